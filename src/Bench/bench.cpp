@@ -0,0 +1,314 @@
+// src/Bench/bench.cpp
+//
+// Benchmarks of the hydraulic core and of the branch-and-bound hot paths (make bench).
+// Each benchmark runs warm-up calls, then times single calls (setup excluded) and reports
+// statistics over the repetitions in microseconds. The results of all networks are written
+// to one JSON file, so that the runs of two commits can be compared.
+
+#include "CLI/BBConfig.h"
+#include "CLI/BBConstraints.h"
+#include "CLI/Console.h"
+
+#include "Core/hydbalance.h"
+#include "Core/network.h"
+#include "Core/project.h"
+#include "Elements/link.h"
+#include "Elements/node.h"
+#include "Solvers/ggasolver.h"
+#include "Solvers/hydstate.h"
+#include "Solvers/matrixsolver.h"
+#include "epanet3.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mpi.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+using Epanet::Project;
+
+/**
+ * @brief Command line of the benchmark driver
+ */
+class BenchConfig
+{
+public:
+  BenchConfig(int argc, char *argv[])
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (arg == "-i" || arg == "--input")
+        networks.push_back(argv[++i]);
+      else if (arg == "-o" || arg == "--output")
+        output = argv[++i];
+      else if (arg == "-w" || arg == "--warmup")
+        warmup = std::max(0, std::stoi(argv[++i]));
+      else if (arg == "-r" || arg == "--repetitions")
+        repetitions = std::max(1, std::stoi(argv[++i]));
+      else if (arg == "--max_s")
+        max_s = std::max(0.0, std::stod(argv[++i]));
+      else if (arg == "--label")
+        label = argv[++i];
+      else
+        throw std::runtime_error("bench: unknown argument '" + arg + "'");
+    }
+    if (networks.empty()) networks.push_back("networks/any-town.inp");
+  }
+
+  std::vector<std::string> networks; // INP files (constraints of the B&B benchmarks: same name with a .json extension)
+  std::string output = "bench.json";
+  std::string label;                  // free text stored with the results (e.g., the commit)
+  int warmup = 10;                    // untimed calls before the repetitions
+  int repetitions = 200;              // timed calls (fewer if max_s is reached)
+  double max_s = 2.0;                 // time budget of the repetitions of one benchmark (seconds, at least 3 calls)
+};
+
+/**
+ * @brief Times benchmarks and collects their statistics
+ */
+class Bench
+{
+public:
+  explicit Bench(const BenchConfig &config) : config(config)
+  {
+  }
+
+  /**
+   * @brief Times body() over the repetitions, calling setup() untimed before each call
+   */
+  void run(const std::string &network, const std::string &name, const std::function<void()> &setup, const std::function<void()> &body)
+  {
+    for (int i = 0; i < config.warmup; ++i)
+    {
+      setup();
+      body();
+    }
+
+    std::vector<double> samples;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                                 std::chrono::duration<double>(config.max_s));
+    while ((int)samples.size() < config.repetitions && (samples.size() < 3 || std::chrono::steady_clock::now() < deadline))
+    {
+      setup();
+      auto tic = std::chrono::steady_clock::now();
+      body();
+      auto toc = std::chrono::steady_clock::now();
+      samples.push_back(std::chrono::duration<double, std::micro>(toc - tic).count());
+    }
+
+    std::sort(samples.begin(), samples.end());
+    const size_t n = samples.size();
+    double mean = 0.0, var = 0.0;
+    for (double s : samples) mean += s / n;
+    for (double s : samples) var += (s - mean) * (s - mean) / std::max<size_t>(n - 1, 1);
+    const double median = (n % 2) ? samples[n / 2] : 0.5 * (samples[n / 2 - 1] + samples[n / 2]);
+
+    results.push_back({{"network", network},
+                       {"name", name},
+                       {"unit", "us"},
+                       {"warmup", config.warmup},
+                       {"repetitions", n},
+                       {"min", samples.front()},
+                       {"median", median},
+                       {"mean", mean},
+                       {"stddev", std::sqrt(var)},
+                       {"p90", samples[std::min(n - 1, (size_t)std::ceil(0.9 * n) - 1)]},
+                       {"max", samples.back()}});
+    Console::printf(Console::Color::WHITE, "  %-36s %12.2f us (median, n=%zu, min=%.2f, stddev=%.2f)\n", name.c_str(), median, n,
+                    samples.front(), std::sqrt(var));
+  }
+
+  nlohmann::json results = nlohmann::json::array();
+
+private:
+  const BenchConfig &config;
+};
+
+// Benchmarks of one network
+static void bench_network(Bench &bench, const std::string &inp)
+{
+  Project p;
+  CHK(p.load(inp.c_str()), "bench: Load " + inp);
+  Network *nw = p.getNetwork();
+  nw->options.setOption(Options::TimeOption::TOTAL_DURATION, 24 * 3600);
+  CHK(p.initSolver(EN_INITFLOW), "bench: Init solver");
+  int t = 0;
+  CHK(p.runSolver(&t), "bench: Run solver");
+
+  const int num_nodes = nw->count(Element::NODE);
+  const int num_links = nw->count(Element::LINK);
+  Console::printf(Console::Color::BRIGHT_YELLOW, "%s: %d nodes, %d links\n", inp.c_str(), num_nodes, num_links);
+
+  // state at the start of the simulation (demands set, heads and flows solved)
+  ProjectData state;
+  p.copy_to(state);
+  auto restore = [&]() { p.copy_from(state); };
+  auto none = []() {};
+
+  // Hydraulic solver and matrix solver of the network's options, outside the engine
+  std::unique_ptr<MatrixSolver> ms(MatrixSolver::factory(nw->option(Options::MATRIX_SOLVER), nw->msgLog));
+  std::vector<int> node1(num_links), node2(num_links);
+  for (int k = 0; k < num_links; ++k)
+  {
+    node1[k] = nw->link(k)->fromNode->index;
+    node2[k] = nw->link(k)->toNode->index;
+  }
+  // Same row ordering as the engine
+  std::vector<double> xc(num_nodes), yc(num_nodes);
+  for (int i = 0; i < num_nodes; ++i)
+  {
+    xc[i] = nw->node(i)->xCoord;
+    yc[i] = nw->node(i)->yCoord;
+  }
+  ms->setOrdering(nw->option(Options::MATRIX_ORDERING), xc, yc);
+  if (!ms->init(num_nodes, num_links, node1.data(), node2.data())) throw std::runtime_error("bench: Init matrix solver");
+
+  std::unique_ptr<HydSolver> gga(HydSolver::factory(nw->option(Options::HYD_SOLVER), nw, ms.get()));
+  int trials = 0;
+  bench.run(inp, "GGASolver::solve", restore, [&]() { gga->solve(3600.0, trials); });
+
+  // Loop flow formulation (falls back to GGA where it does not apply)
+  std::unique_ptr<HydSolver> nullSpace(HydSolver::factory("NULLSPACE", nw, ms.get()));
+  bench.run(inp, "NullSpaceSolver::solve", restore, [&]() { nullSpace->solve(3600.0, trials); });
+
+  // Matrix of the network's pattern: a weighted graph Laplacian plus the identity (SPD)
+  ms->reset();
+  for (int k = 0; k < num_links; ++k)
+  {
+    const double a = 1.0 / (1.0 + k % 7);
+    ms->addToOffDiag(k, -a);
+    ms->addToDiag(node1[k], a);
+    ms->addToDiag(node2[k], a);
+  }
+  for (int i = 0; i < num_nodes; ++i)
+  {
+    ms->addToDiag(i, 1.0);
+    ms->setRhs(i, 1.0);
+  }
+  std::vector<char> matrix(ms->dataSize());
+  ms->copy_to(matrix.data());
+  std::vector<double> x(num_nodes);
+  bench.run(
+      inp, "MatrixSolver::solve (" + nw->option(Options::MATRIX_SOLVER) + ")",
+      [&]()
+      {
+        ms->copy_from(matrix.data());
+        ms->clearFactor();
+      },
+      [&]() { ms->solve(num_nodes, x.data()); });
+
+  // Same matrix with one link's coefficient changed at every other solve
+  // (a low-rank update of the kept factor, if the solver keeps one)
+  int changes = 0;
+  bench.run(
+      inp, "MatrixSolver::solve (one link changed)",
+      [&]()
+      {
+        ms->copy_from(matrix.data());
+        if (changes++ % 2 == 0)
+        {
+          ms->addToOffDiag(0, -0.5);
+          ms->addToDiag(node1[0], 0.5);
+          ms->addToDiag(node2[0], 0.5);
+        }
+      },
+      [&]() { ms->solve(num_nodes, x.data()); });
+
+  HydBalance balance;
+  HydState hs;
+  hs.init(nw);
+  std::vector<double> dH(num_nodes, 0.0), dQ(num_links, 0.0), xQ(num_nodes, 0.0);
+  bench.run(
+      inp, "HydBalance::evaluate",
+      [&]()
+      {
+        restore();
+        hs.gather(nw);
+      },
+      [&]() { balance.evaluate(1.0, dH.data(), dQ.data(), xQ.data(), hs, nw); });
+
+  ProjectData copy;
+  bench.run(inp, "Project::copy_to", none, [&]() { p.copy_to(copy); });
+  bench.run(inp, "Project::copy_from", none, [&]() { p.copy_from(state); });
+
+  // Opening a copy of the project (the symbolic factorization is shared with p)
+  bench.run(inp, "Project::clone/initSolver", none,
+            [&]()
+            {
+              Project q;
+              CHK(q.clone(&p), "bench: Clone project");
+              CHK(q.initSolver(EN_INITFLOW), "bench: Init solver");
+            });
+
+  // B&B feasibility checks (only with a constraint spec next to the network)
+  const std::string spec = inp.substr(0, inp.find_last_of('.')) + ".json";
+  if (std::ifstream(spec).good())
+  {
+    std::string args[] = {"bench", "-i", inp, "-c", spec, "-h", "24"};
+    char *argv[] = {args[0].data(), args[1].data(), args[2].data(), args[3].data(), args[4].data(), args[5].data(), args[6].data()};
+    BBConfig config(7, argv);
+    BBConstraints constraints(config);
+    Project q;
+    constraints.clone_project(q);
+    q.getNetwork()->options.setOption(Options::TimeOption::TOTAL_DURATION, 24 * 3600);
+    CHK(q.initSolver(EN_INITFLOW), "bench: Init solver");
+    int dt = 0;
+    CHK(q.runSolver(&t), "bench: Run solver");
+    CHK(q.advanceSolver(&dt), "bench: Advance solver");
+    double cost = 0.0;
+    bench.run(inp, "BBConstraints::check_feasibility", none, [&]() { constraints.check_feasibility(q, dt, 1, cost, false); });
+    constraints.finish_sync();
+  }
+
+  // Extended period simulation
+  bench.run(inp, "runSolver/advanceSolver (24 h)", none,
+            [&]()
+            {
+              CHK(p.initSolver(EN_INITFLOW), "bench: Init solver");
+              int t = 0, dt = 0;
+              do
+              {
+                CHK(p.runSolver(&t), "bench: Run solver");
+                CHK(p.advanceSolver(&dt), "bench: Advance solver");
+              } while (dt > 0);
+            });
+}
+
+int main(int argc, char *argv[])
+{
+  // BBConstraints shares its incumbent through MPI
+  MPI_Init(&argc, &argv);
+
+  try
+  {
+    BenchConfig config(argc, argv);
+    Bench bench(config);
+    for (const std::string &inp : config.networks) bench_network(bench, inp);
+
+    char date[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    nlohmann::json j;
+    j["label"] = config.label;
+    j["date"] = date;
+    j["benchmarks"] = bench.results;
+    std::ofstream f(config.output);
+    f << j.dump(2);
+    Console::printf(Console::Color::BRIGHT_GREEN, "💾 Writing benchmarks to file: %s\n", config.output.c_str());
+  }
+  catch (const std::exception &e)
+  {
+    Console::printf(Console::Color::BRIGHT_RED, "Error: %s\n", e.what());
+    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+  }
+
+  MPI_Finalize();
+  return EXIT_SUCCESS;
+}
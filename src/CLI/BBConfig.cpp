@@ -2,6 +2,7 @@
 #include "BBConfig.h"
 #include "Console.h"
 
+#include <algorithm>
 #include <mpi.h>
 #include <string>
 
@@ -39,6 +40,13 @@ void BBConfig::generateFilenames()
   {
     throw std::runtime_error("Filename truncation occurred in fn_profile!");
   }
+
+  // Format the trace filename (one file for all ranks)
+  ret = snprintf(fn_trace, sizeof(fn_trace), "run_h_%02d_a_%02d_l_%02d_n_%02d_trace.json", h_max, max_actuations, level, np);
+  if (ret < 0 || static_cast<size_t>(ret) >= sizeof(fn_trace))
+  {
+    throw std::runtime_error("Filename truncation occurred in fn_trace!");
+  }
 }
 
 BBConfig::BBConfig(int argc, char *argv[])
@@ -56,6 +64,8 @@ BBConfig::BBConfig(int argc, char *argv[])
     std::string arg = argv[i];
     if (arg == "-i" || arg == "--input")
       inpFile = argv[++i];
+    else if (arg == "-c" || arg == "--constraints")
+      constraintsFile = argv[++i];
     else if (arg == "-v" || arg == "--verbose")
       verbose = true;
     else if (arg == "-h" || arg == "--h_max")
@@ -64,6 +74,45 @@ BBConfig::BBConfig(int argc, char *argv[])
       max_actuations = std::stoi(argv[++i]);
     else if (arg == "-l" || arg == "--level")
       level = std::stoi(argv[++i]);
+    else if (arg == "-s" || arg == "--schedule")
+      schedule = argv[++i];
+    else if (arg == "-t" || arg == "--threads")
+      num_threads = std::max(1, std::stoi(argv[++i]));
+    else if (arg == "--siblings")
+      siblings = std::max(1, std::stoi(argv[++i]));
+    else if (arg == "--search")
+      search = argv[++i];
+    else if (arg == "--open_mb")
+      open_mb = std::max(0, std::stoi(argv[++i]));
+    else if (arg == "--no_bound")
+      cost_bound = false;
+    else if (arg == "--dominance")
+      dominance = true;
+    else if (arg == "--tt_mb")
+      tt_mb = std::max(0, std::stoi(argv[++i]));
+    else if (arg == "--tt_tol")
+      tt_tol = std::stod(argv[++i]);
+    else if (arg == "--prefix_mb")
+      prefix_mb = std::max(0, std::stoi(argv[++i]));
+    else if (arg == "--memo_mb")
+      memo_mb = std::max(0, std::stoi(argv[++i]));
+    else if (arg == "--heuristic_s")
+      heuristic_s = std::max(0.0, std::stod(argv[++i]));
+    else if (arg == "--sync_steps")
+      sync_steps = std::max(0, std::stoi(argv[++i]));
+    else if (arg == "--trace")
+      trace = true;
+    else if (arg == "--trace_events")
+      trace_events = std::max(0, std::stoi(argv[++i]));
+  }
+
+  // Constraint spec next to the input file
+  if (constraintsFile.empty())
+  {
+    const size_t dot = inpFile.find_last_of('.');
+    const size_t slash = inpFile.find_last_of('/');
+    const bool has_ext = dot != std::string::npos && (slash == std::string::npos || dot > slash);
+    constraintsFile = (has_ext ? inpFile.substr(0, dot) : inpFile) + ".json";
   }
 
   // Buffers for filenames
@@ -82,11 +131,24 @@ void BBConfig::show() const
   Console::printf(Console::Color::CYAN, "════════════════════════════════════════\n");
   Console::printf(Console::Color::CYAN, "Branch & Bound Configuration:\n");
   Console::printf(Console::Color::WHITE, "  Input file:      %s\n", inpFile.c_str());
+  Console::printf(Console::Color::WHITE, "  Constraints:     %s\n", constraintsFile.c_str());
   Console::printf(Console::Color::WHITE, "  Max hours:       %d\n", h_max);
   Console::printf(Console::Color::WHITE, "  Max actuations:  %d\n", max_actuations);
   Console::printf(Console::Color::WHITE, "  Level:           %d\n", level);
   Console::printf(Console::Color::WHITE, "  Verbose:         %s\n", verbose ? "true" : "false");
+  Console::printf(Console::Color::WHITE, "  Schedule:        %s\n", schedule.c_str());
+  Console::printf(Console::Color::WHITE, "  Threads:         %d\n", num_threads);
+  Console::printf(Console::Color::WHITE, "  Sibling threads: %d\n", siblings);
+  Console::printf(Console::Color::WHITE, "  Search:          %s\n", search.c_str());
+  Console::printf(Console::Color::WHITE, "  Open list cap:   %d MB\n", open_mb);
+  Console::printf(Console::Color::WHITE, "  Cost bound:      %s\n", cost_bound ? "true" : "false");
+  Console::printf(Console::Color::WHITE, "  Dominance:       %s (%d MB, tol=%g)\n", dominance ? "true" : "false", tt_mb, tt_tol);
+  Console::printf(Console::Color::WHITE, "  Prefix states:   %d MB\n", prefix_mb);
+  Console::printf(Console::Color::WHITE, "  Hour memo:       %d MB\n", memo_mb);
+  Console::printf(Console::Color::WHITE, "  Heuristic:       %g s\n", heuristic_s);
+  Console::printf(Console::Color::WHITE, "  Sync steps:      %d\n", sync_steps);
   Console::printf(Console::Color::WHITE, "  Stats file:      %s\n", fn_stats);
   Console::printf(Console::Color::WHITE, "  Best file:       %s\n", fn_best);
   Console::printf(Console::Color::WHITE, "  Profile file:    %s\n", fn_profile);
+  if (trace) Console::printf(Console::Color::WHITE, "  Trace file:      %s (%d events per thread)\n", fn_trace, trace_events);
 }
@@ -11,13 +11,30 @@ public:
   void show() const;
 
   std::string inpFile;
+  std::string constraintsFile;        // JSON constraint spec (default: input file with a .json extension)
   int h_max = 24;
   int max_actuations = 3;
   int level = 5;
   bool verbose = false;
+  std::string schedule = "dynamic"; // task distribution: static|dynamic
+  int num_threads = 1;                // worker threads per process
+  int siblings = 1;                   // threads simulating the children of a DFS node together (1: sequential)
+  std::string search = "dfs";         // node selection: dfs|best-first|hybrid
+  int open_mb = 1024;                 // memory cap of the best-first open list (MB per thread)
+  bool cost_bound = true;             // prune on cost plus a lower bound on the remaining cost
+  bool dominance = false;             // prune partial schedules dominated in the transposition table
+  int tt_mb = 64;                     // memory of the transposition table (MB per process)
+  double tt_tol = 0.01;               // quantization step of the tank levels in the table keys
+  int prefix_mb = 256;                // memory of the shared task prefix states (MB per process, 0: disabled)
+  int memo_mb = 0;                    // memory of the one-hour simulation memo (MB per process, 0: disabled)
+  double heuristic_s = 10.0;          // time budget of the warm-start heuristic (seconds, on by default, 0: disabled)
+  int sync_steps = 10;                // hydraulic steps between reads of the global best cost (0: between tasks only)
+  bool trace = false;                 // record a timeline of the traced scopes (Chrome trace JSON)
+  int trace_events = 1000000;         // trace events kept per thread
   char fn_stats[256];
   char fn_best[256];
   char fn_profile[256];
+  char fn_trace[256];
 
 private:
   void generateFilenames();
@@ -9,11 +9,14 @@
 #include "BBConfig.h"
 #include "Profiler.h"
 
+#include "Core/constants.h"
 #include "Elements/pattern.h"
+#include "Elements/tank.h"
 
 #include <algorithm>
 #include <chrono>
 #include <cstring>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -25,39 +28,67 @@
 // Static map of prune reasons to labels
 std::map<BBPrune::Reason, std::string> BBPrune::labels = {
     {BBPrune::NONE, "NONE"}, {BBPrune::PRESSURES, "PRESSURES"},   {BBPrune::LEVELS, "LEVELS"},    {BBPrune::STABILITY, "STABILITY"},
-    {BBPrune::COST, "COST"}, {BBPrune::ACTUATIONS, "ACTUATIONS"}, {BBPrune::TIMESTEP, "TIMESTEP"}};
+    {BBPrune::COST, "COST"}, {BBPrune::ACTUATIONS, "ACTUATIONS"}, {BBPrune::TIMESTEP, "TIMESTEP"},
+    {BBPrune::DOMINANCE, "DOMINANCE"}};
 
 
 // Constructor
 BBConstraints::BBConstraints(const BBConfig &config)
 {
-  // Initialize nodes and tanks with placeholder IDs
-  nodes = {{"55", 0}, {"90", 0}, {"170", 0}};
-  tanks = {{"65", 0}, {"165", 0}, {"265", 0}};
-  pumps = {{"111", 0}, {"222", 0}, {"333", 0}};
   best_cost_local = std::numeric_limits<double>::max();
 
-  // Retrieve node and tank IDs from the input file
+  // Load the network and compile the constraints against it
   get_network_data(config.inpFile);
+  load_spec(config.constraintsFile);
+  init_cost_bound(config);
 
   best_cost_global = std::numeric_limits<double>::max();
   best_cost_local = std::numeric_limits<double>::max();
-  request_nonblocking = MPI_REQUEST_NULL;
+
+  // Window with the global best cost: rank 0 holds it, every process updates and reads it
+  int rank;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Win_allocate(rank == 0 ? sizeof(double) : 0, sizeof(double), MPI_INFO_NULL, MPI_COMM_WORLD, &win_base, &win_best);
+  MPI_Win_lock_all(0, win_best);
+  if (rank == 0)
+  {
+    *win_base = std::numeric_limits<double>::max();
+    MPI_Win_sync(win_best);
+  }
+  MPI_Barrier(MPI_COMM_WORLD);
 }
 
 void BBConstraints::sync_best()
 {
-  ProfileScope scope("sync_best");
+  PROFILE_TRACE_SCOPE("sync_best");
+
+  double best_global;
+  MPI_Fetch_and_op(nullptr, &best_global, MPI_DOUBLE, 0, 0, MPI_NO_OP, win_best);
+  MPI_Win_flush(0, win_best);
+  best_cost_global = std::min(best_cost_global.load(), best_global);
+}
+
+void BBConstraints::publish_best(double cost)
+{
+  PROFILE_TRACE_SCOPE("publish_best");
+
+  MPI_Accumulate(&cost, 1, MPI_DOUBLE, 0, 0, 1, MPI_DOUBLE, MPI_MIN, win_best);
+  MPI_Win_flush(0, win_best);
+}
+
+void BBConstraints::finish_sync()
+{
+  PROFILE_TRACE_SCOPE("finish_sync");
 
-  int err, flag;
-  MPI_Request request_copy = request_nonblocking;
+  if (win_best == MPI_WIN_NULL) return;
 
-  if (request_nonblocking == MPI_REQUEST_NULL)
-    MPI_Iallreduce(&best_cost_local, &best_cost_global, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD, &request_nonblocking);
+  // Final (exact) global best
+  double best_local = best_cost_local, best_global;
+  MPI_Allreduce(&best_local, &best_global, 1, MPI_DOUBLE, MPI_MIN, MPI_COMM_WORLD);
+  best_cost_global = std::min(best_cost_global.load(), best_global);
 
-  // MPI_Test will update the request_nonblocking when the allreduce is complete
-  err = MPI_Test(&request_nonblocking, &flag, MPI_STATUS_IGNORE);
-  if (err != MPI_SUCCESS) throw std::runtime_error("BBConstraints::sync_best: MPI_Test failed");
+  MPI_Win_unlock_all(win_best);
+  MPI_Win_free(&win_best);
 }
 
 // Destructor
@@ -68,9 +99,18 @@ BBConstraints::~BBConstraints()
 
 void BBConstraints::update_best(double cost, std::vector<int> x, std::vector<int> y)
 {
-  best_cost_local = std::min(best_cost_local, cost);
-  best_x = x;
-  best_y = y;
+  {
+    std::lock_guard<std::mutex> lock(best_mutex);
+    if (cost >= best_cost_local) return;
+    best_cost_local = cost;
+    best_x = std::move(x);
+    best_y = std::move(y);
+  }
+  PROFILE_EVENT("incumbent", "cost", cost);
+
+  // Let the other processes prune with the new incumbent right away
+#pragma omp critical(bb_mpi)
+  publish_best(cost);
 }
 
 // Function to display the constraints
@@ -84,53 +124,96 @@ void BBConstraints::show() const
 
   // Print list of node IDs
   Console::printf(Console::Color::BRIGHT_WHITE, "Nodes: [ ");
-  for (const auto &node : nodes)
-    Console::printf(Console::Color::BRIGHT_WHITE, "%s ", node.first.c_str());
+  for (const auto &node_name : node_names)
+    Console::printf(Console::Color::BRIGHT_WHITE, "%s ", node_name.c_str());
   Console::printf(Console::Color::BRIGHT_WHITE, "]\n");
 
   // Print list of tank IDs
   Console::printf(Console::Color::BRIGHT_WHITE, "Tanks: [ ");
-  for (const auto &tank : tanks)
-    Console::printf(Console::Color::BRIGHT_WHITE, "%s ", tank.first.c_str());
+  for (const auto &tank_name : tank_names)
+    Console::printf(Console::Color::BRIGHT_WHITE, "%s ", tank_name.c_str());
   Console::printf(Console::Color::BRIGHT_WHITE, "]\n");
 
   // Print list of pump IDs
   Console::printf(Console::Color::BRIGHT_WHITE, "Pumps: [ ");
-  for (const auto &pump : pumps)
-    Console::printf(Console::Color::BRIGHT_WHITE, "%s ", pump.first.c_str());
+  for (const auto &pump_name : pump_names)
+    Console::printf(Console::Color::BRIGHT_WHITE, "%s ", pump_name.c_str());
   Console::printf(Console::Color::BRIGHT_WHITE, "]\n");
 }
 
 void BBConstraints::get_network_data(std::string inpFile)
 {
-  Project p;
-  CHK(p.load(inpFile.c_str()), "BBConstraints::get_network_elements_indices: Load project");
+  CHK(prototype.load(inpFile.c_str()), "BBConstraints::get_network_elements_indices: Load project");
 
-  Network *nw = p.getNetwork();
+  Network *nw = prototype.getNetwork();
 
   // Get the user-defined Hydraulic timestep
   hyd_timestep = nw->option(Options::HYD_STEP);
+  pcf = nw->ucf(Units::PRESSURE);
+  lcf = nw->ucf(Units::LENGTH);
+}
 
-  // Find node IDs
-  for (auto &node : nodes)
+void BBConstraints::load_spec(const std::string &fn)
+{
+  std::ifstream f(fn);
+  if (!f) throw std::runtime_error("BBConstraints::load_spec: cannot open constraints file " + fn);
+  nlohmann::json spec;
+  try
   {
-    const std::string &node_name = node.first;
-    node.second = nw->indexOf(Element::NODE, node_name);
+    f >> spec;
   }
+  catch (const nlohmann::json::exception &e)
+  {
+    throw std::runtime_error("BBConstraints::load_spec: " + fn + ": " + e.what());
+  }
+
+  Network *nw = prototype.getNetwork();
+  auto find = [&](Element::ElementType type, const std::string &id, const char *what)
+  {
+    const int index = nw->indexOf(type, id);
+    if (index < 0) throw std::runtime_error("BBConstraints::load_spec: unknown " + std::string(what) + " " + id + " in " + fn);
+    return index;
+  };
+  const double inf = std::numeric_limits<double>::infinity();
 
-  // Find tank IDs
-  for (auto &tank : tanks)
+  for (const auto &node : spec.at("nodes"))
   {
-    const std::string &tank_name = tank.first;
-    tank.second = nw->indexOf(Element::NODE, tank_name);
+    const std::string id = node.at("id");
+    node_names.push_back(id);
+    node_bounds.push_back({find(Element::NODE, id, "node"), node.at("pressure_min").get<double>(),
+                           node.value("pressure_max", inf)});
   }
 
-  // Find pump IDs
-  for (auto &pump : pumps)
+  for (const auto &tank : spec.at("tanks"))
   {
-    const std::string &pump_name = pump.first;
-    pump.second = nw->indexOf(Element::LINK, pump_name);
+    const std::string id = tank.at("id");
+    const int index = find(Element::NODE, id, "tank");
+    if (nw->node(index)->type() != Node::TANK) throw std::runtime_error("BBConstraints::load_spec: node " + id + " is not a tank");
+    tank_names.push_back(id);
+    tank_bounds.push_back({index, tank.at("level_min").get<double>(), tank.at("level_max").get<double>(),
+                           tank.value("level_final", -inf)});
   }
+
+  for (const std::string id : spec.at("pumps"))
+  {
+    const int index = find(Element::LINK, id, "pump");
+    if (nw->link(index)->type() != Link::PUMP) throw std::runtime_error("BBConstraints::load_spec: link " + id + " is not a pump");
+    pump_names.push_back(id);
+    pump_index.push_back(index);
+  }
+
+  cost_index = pump_index;
+  if (spec.contains("cost") && spec["cost"].contains("pumps"))
+  {
+    cost_index.clear();
+    for (const std::string id : spec["cost"]["pumps"])
+      cost_index.push_back(find(Element::LINK, id, "pump"));
+  }
+}
+
+void BBConstraints::clone_project(Project &p)
+{
+  CHK(p.clone(&prototype), "BBConstraints::clone_project: Clone project");
 }
 
 // Function to display pressure status
@@ -180,34 +263,32 @@ bool BBConstraints::check_pressures(Project &p, bool verbose)
   if (verbose)
   {
     Console::printf(Console::Color::BRIGHT_WHITE, "\nChecking pressures: [ ");
-    for (const auto &node : nodes)
+    for (const auto &node_name : node_names)
     {
-      Console::printf(Console::Color::BRIGHT_CYAN, "%s ", node.first.c_str());
+      Console::printf(Console::Color::BRIGHT_CYAN, "%s ", node_name.c_str());
     }
     Console::printf(Console::Color::BRIGHT_WHITE, "]\n");
   }
 
-  std::map<std::string, double> thresholds = {{"55", 42}, {"90", 51}, {"170", 30}};
   bool all_ok = true;
 
-  for (const auto &node : nodes)
+  const std::vector<Node *> &network_nodes = p.getNetwork()->nodes;
+  for (size_t i = 0; i < node_bounds.size(); ++i)
   {
-    const std::string &node_name = node.first;
-    const int &node_index = node.second;
-    double pressure;
+    const NodeBound &bound = node_bounds[i];
+    const Node *node = network_nodes[bound.index];
+    const double pressure = (node->head - node->elev) * pcf;
 
-    // Retrieve node pressure
-    CHK(EN_getNodeValue(node_index, EN_PRESSURE, &pressure, &p), "Get node pressure");
-
-    // Check if pressure meets the threshold
-    bool is_feasible = pressure >= thresholds[node_name];
+    // Check if pressure is within the band
+    bool is_feasible = (pressure >= bound.pressure_min) && (pressure <= bound.pressure_max);
     if (!is_feasible)
     {
       all_ok = false;
+      if (!verbose) break;
     }
 
     // Display pressure status
-    if (verbose) show_pressures(is_feasible, node_name, pressure, thresholds[node_name]);
+    if (verbose) show_pressures(is_feasible, node_names[i], pressure, bound.pressure_min);
   }
 
   return all_ok;
@@ -219,33 +300,29 @@ bool BBConstraints::check_levels(Project &p, bool verbose)
   if (verbose)
   {
     Console::printf(Console::Color::BRIGHT_WHITE, "\nChecking levels: [ ");
-    for (const auto &tank : tanks)
-      Console::printf(Console::Color::BRIGHT_CYAN, "%s ", tank.first.c_str());
+    for (const auto &tank_name : tank_names)
+      Console::printf(Console::Color::BRIGHT_CYAN, "%s ", tank_name.c_str());
     Console::printf(Console::Color::BRIGHT_WHITE, "]\n");
   }
 
-  const double level_min = 66.531;
-  const double level_max = 71.529;
   bool all_ok = true;
 
-  for (const auto &tank : tanks)
+  const std::vector<Node *> &network_nodes = p.getNetwork()->nodes;
+  for (size_t i = 0; i < tank_bounds.size(); ++i)
   {
-    const std::string &tank_name = tank.first;
-    const int &tank_index = tank.second;
-    double level;
-
-    // Retrieve tank level
-    CHK(EN_getNodeValue(tank_index, EN_HEAD, &level, &p), "Get tank level");
+    const TankBound &bound = tank_bounds[i];
+    const double level = network_nodes[bound.index]->head * lcf;
 
     // Check if level is within acceptable range
-    bool is_feasible = (level >= level_min) && (level <= level_max);
+    bool is_feasible = (level >= bound.level_min) && (level <= bound.level_max);
     if (!is_feasible)
     {
       all_ok = false;
+      if (!verbose) break;
     }
 
     // Display level status
-    if (verbose) show_levels(is_feasible, tank_name, level, level_min, level_max);
+    if (verbose) show_levels(is_feasible, tank_names[i], level, bound.level_min, bound.level_max);
   }
 
   return all_ok;
@@ -257,32 +334,28 @@ BBPrune::Reason BBConstraints::check_stability(Project &p, bool verbose)
   if (verbose)
   {
     Console::printf(Console::Color::BRIGHT_WHITE, "\nChecking stability: [ ");
-    for (const auto &tank : tanks)
-      Console::printf(Console::Color::BRIGHT_CYAN, "%s ", tank.first.c_str());
+    for (const auto &tank_name : tank_names)
+      Console::printf(Console::Color::BRIGHT_CYAN, "%s ", tank_name.c_str());
     Console::printf(Console::Color::BRIGHT_WHITE, "]\n");
   }
 
-  const double initial_level = 66.93;
   bool all_ok = true;
 
-  for (const auto &tank : tanks)
+  const std::vector<Node *> &network_nodes = p.getNetwork()->nodes;
+  for (size_t i = 0; i < tank_bounds.size(); ++i)
   {
-    const std::string &tank_name = tank.first;
-    const int &tank_index = tank.second;
-    double level;
-
-    // Retrieve tank level
-    CHK(EN_getNodeValue(tank_index, EN_HEAD, &level, &p), "Get tank level");
+    const TankBound &bound = tank_bounds[i];
+    const double level = network_nodes[bound.index]->head * lcf;
 
-    // Check if level meets the initial stability condition
-    bool is_feasible = level >= initial_level;
+    // Check if level meets the final level target
+    bool is_feasible = level >= bound.level_final;
     if (!is_feasible)
     {
       all_ok = false;
     }
 
     // Display stability status
-    if (verbose) show_stability(is_feasible, tank_name, level, initial_level);
+    if (verbose) show_stability(is_feasible, tank_names[i], level, bound.level_final);
   }
 
   return all_ok ? BBPrune::Reason::NONE : BBPrune::Reason::STABILITY;
@@ -292,21 +365,23 @@ BBPrune::Reason BBConstraints::check_stability(Project &p, bool verbose)
 bool BBConstraints::check_cost(Project &p, double &cost, bool verbose)
 {
   cost = calc_cost(p);
-  bool is_feasible = cost < std::min(best_cost_local, best_cost_global);
+  const double cost_max = std::min(best_cost_local.load(), best_cost_global.load());
+  const double lb = (cost_max < std::numeric_limits<double>::max()) ? cost_bound(p) : 0.0;
+  bool is_feasible = cost + lb < cost_max;
   if (verbose)
   {
-    Console::printf(Console::Color::BRIGHT_WHITE, "\nChecking cost:\n");
+    Console::printf(Console::Color::BRIGHT_WHITE, "\nChecking cost (remaining >= %.2f):\n", lb);
     if (is_feasible)
     {
-      if (best_cost_local > 999999999)
+      if (cost_max > 999999999)
         Console::printf(Console::Color::GREEN, "  \u2705 cost=%.2f < cost_max=inf\n", cost);
       else
-        Console::printf(Console::Color::GREEN, "  \u2705 cost=%.2f < cost_max=%.2f\n", cost, best_cost_local);
+        Console::printf(Console::Color::GREEN, "  \u2705 cost=%.2f < cost_max=%.2f\n", cost, cost_max);
     }
-    else if (best_cost_local > 999999999)
+    else if (cost_max > 999999999)
       Console::printf(Console::Color::RED, "  \u274C cost=%.2f >= cost_max=inf\n", cost);
     else
-      Console::printf(Console::Color::RED, "  \u274C cost=%.2f >= cost_max=%.2f\n", cost, best_cost_local);
+      Console::printf(Console::Color::RED, "  \u274C cost=%.2f >= cost_max=%.2f\n", cost, cost_max);
   }
   return is_feasible;
 }
@@ -316,40 +391,258 @@ double BBConstraints::calc_cost(Project &p) const
 {
   Network *nw = p.getNetwork();
   double cost = 0.0;
-  for (const auto &pump : pumps)
+  for (int index : cost_index)
   {
-    Pump *pump_link = (Pump *)nw->link(pump.second);
+    Pump *pump_link = (Pump *)nw->link(index);
     cost += pump_link->pumpEnergy.adjustedTotalCost;
   }
   return cost;
 }
 
+// Function to read the tank levels (in the order of tank_bounds)
+void BBConstraints::get_levels(Project &p, double *levels) const
+{
+  const std::vector<Node *> &network_nodes = p.getNetwork()->nodes;
+  for (size_t i = 0; i < tank_bounds.size(); ++i)
+    levels[i] = network_nodes[tank_bounds[i].index]->head * lcf;
+}
+
+// Function to precompute the tables of the lower bound on the remaining cost
+void BBConstraints::init_cost_bound(const BBConfig &config)
+{
+  use_cost_bound = config.cost_bound;
+  const size_t num_nodes = node_bounds.size();
+  lb_demand.assign((config.h_max + 1) * num_nodes, 0.0);
+  lb_price.assign(config.h_max + 1, std::numeric_limits<double>::max());
+  lb_net_demand.assign(config.h_max + 1, 0.0);
+  lb_net_cost.assign(config.h_max + 1, 0.0);
+  lb_volume.clear();
+  lb_volume_min.clear();
+  lb_sinks.clear();
+
+  // Scratch copy of the network with its patterns initialized
+  Project q;
+  clone_project(q);
+  Network *nw = q.getNetwork();
+  nw->options.setOption(Options::TimeOption::TOTAL_DURATION, 3600 * config.h_max);
+  CHK(q.initSolver(EN_INITFLOW), "BBConstraints::init_cost_bound: Init solver");
+
+  const double multiplier = nw->option(Options::DEMAND_MULTIPLIER);
+  const int demand_pattern = nw->option(Options::DEMAND_PATTERN);
+
+  // Demands, prices and reservoir heads over each pattern period of each hour
+  std::vector<double> price(config.h_max + 1, std::numeric_limits<double>::max());
+  std::vector<double> net_rate(config.h_max + 1, 0.0); // largest total demand (cfs) in each hour
+  bool net_inflow = false;                              // some junction supplies water
+  double head_source = -std::numeric_limits<double>::max();
+  for (int h = 1; h <= config.h_max; ++h)
+  {
+    int t = 3600 * (h - 1);
+    while (t < 3600 * h)
+    {
+      int t_next = 3600 * h;
+      for (Pattern *pattern : nw->patterns)
+      {
+        pattern->advance(t);
+        t_next = std::min(t_next, pattern->nextTime(t));
+      }
+      const double pattern_factor = (demand_pattern >= 0) ? nw->pattern(demand_pattern)->currentFactor() : 1.0;
+
+      for (size_t j = 0; j < num_nodes; ++j)
+      {
+        Node *junction = nw->node(node_bounds[j].index);
+        junction->findFullDemand(multiplier, pattern_factor);
+        lb_demand[h * num_nodes + j] += std::max(junction->fullDemand, 0.0) * (t_next - t);
+      }
+      double rate = 0.0;
+      for (Node *node : nw->nodes)
+      {
+        if (node->type() != Node::JUNCTION) continue;
+        node->findFullDemand(multiplier, pattern_factor);
+        net_inflow = net_inflow || node->fullDemand < 0.0;
+        rate += node->fullDemand;
+      }
+      lb_net_demand[h] += rate * (t_next - t);
+      net_rate[h] = std::max(net_rate[h], rate);
+      for (int index : cost_index)
+      {
+        Pump *pump_link = (Pump *)nw->link(index);
+        price[h] = std::min(price[h], pump_link->pumpEnergy.findCostFactor(pump_link, nw));
+      }
+      for (Node *node : nw->nodes)
+      {
+        if (node->type() != Node::RESERVOIR) continue;
+        node->setFixedGrade();
+        head_source = std::max(head_source, node->head);
+      }
+      t = t_next;
+    }
+  }
+
+  // Pressure dependent demands may be below the full demand
+  if (nw->option(Options::DEMAND_MODEL) != "FIXED")
+  {
+    std::fill(lb_demand.begin(), lb_demand.end(), 0.0);
+    net_inflow = true;
+  }
+
+  // Suffix sums and minima (demand and price from hour k + 1)
+  for (int k = config.h_max - 1; k >= 0; --k)
+  {
+    for (size_t j = 0; j < num_nodes; ++j) lb_demand[k * num_nodes + j] += lb_demand[(k + 1) * num_nodes + j];
+    lb_price[k] = std::min(lb_price[k + 1], price[k + 1]);
+  }
+
+  // A tank without a final level constraint could supply water for free
+  int num_tanks = 0;
+  for (Node *node : nw->nodes)
+    if (node->type() == Node::TANK) ++num_tanks;
+  for (const TankBound &tank : tank_bounds)
+  {
+    if (tank.level_final == -std::numeric_limits<double>::infinity()) continue;
+    lb_volume.push_back(((Tank *)nw->node(tank.index))->findVolume(tank.level_final / lcf));
+    lb_volume_min.push_back(((Tank *)nw->node(tank.index))->findVolume(tank.level_min / lcf));
+  }
+  if (num_tanks > (int)lb_volume.size()) return;
+
+  // Best efficiency of the pumps
+  double effic_max = 1.0;
+  for (int index : cost_index)
+  {
+    Pump *pump_link = (Pump *)nw->link(index);
+    effic_max = std::max(effic_max, pump_link->pumpEnergy.findMaxEfficiency(pump_link, nw));
+  }
+
+  // Energy (kWh) per ft3 and ft of lift (same formula as PumpEnergy::updateEnergyUsage)
+  const double sg = nw->option(Options::SPEC_GRAVITY);
+  const double energy = sg / 8.814 / (effic_max / 100.0) * KWperHP / 3600.0;
+
+  // Each tank is refilled at no less than its level_min, and each monitored node is supplied at no less
+  // than its minimum pressure head, either directly or through a tank
+  double lift_tank = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < tank_bounds.size(); ++i)
+  {
+    const double lift = std::max(tank_bounds[i].level_min / lcf - head_source, 0.0);
+    lift_tank = std::min(lift_tank, lift);
+    lb_sinks.push_back({(int)i, true, lift * energy});
+  }
+  for (size_t j = 0; j < num_nodes; ++j)
+  {
+    const double lift = std::max(nw->node(node_bounds[j].index)->elev + node_bounds[j].pressure_min / pcf - head_source, 0.0);
+    lb_sinks.push_back({(int)j, false, std::min(lift, lift_tank) * energy});
+  }
+
+  // The water the tanks hold above their final level goes to the dearest sinks first
+  std::stable_sort(lb_sinks.begin(), lb_sinks.end(), [](const CostSink &a, const CostSink &b) { return a.energy > b.energy; });
+
+  // Whole network balance: if the reservoirs only feed the network through costed pumps, every junction's
+  // demand is pumped or drawn from the tanks. A pump whose water reaches a tank lifts it at least to that
+  // tank's level_min; otherwise its water only meets demands, so its flow is at most the total demand and
+  // its head at least the head of its curve at that flow (scheduled pumps run at full speed).
+  bool pumped = !net_inflow && !tank_bounds.empty();
+  for (Link *link : nw->links)
+  {
+    if (link->fromNode->type() != Node::RESERVOIR && link->toNode->type() != Node::RESERVOIR) continue;
+    pumped = pumped && link->type() == Link::PUMP && link->fromNode->type() == Node::RESERVOIR &&
+             std::find(cost_index.begin(), cost_index.end(), link->index) != cost_index.end();
+  }
+  if (!pumped)
+  {
+    lb_net_demand.clear();
+    return;
+  }
+  for (int h = 1; h <= config.h_max; ++h)
+  {
+    double lift = lift_tank;
+    for (Link *link : nw->links)
+    {
+      if (link->fromNode->type() != Node::RESERVOIR) continue;
+      double head_loss, gradient;
+      ((Pump *)link)->pumpCurve.findHeadLoss(1.0, net_rate[h], head_loss, gradient);
+      lift = std::min(lift, std::max(-head_loss, 0.0));
+    }
+    lb_net_cost[h] = price[h] * lift * energy;
+  }
+}
+
+// Function to compute the lower bound on the remaining cost
+double BBConstraints::cost_bound(Project &p) const
+{
+  if (!use_cost_bound || lb_sinks.empty()) return 0.0;
+
+  // Hours that are (partially) left
+  const int h_max = (int)lb_price.size() - 1;
+  const int t = p.getElapsedTime();
+  const int k_price = t / 3600;           // first hour still to be paid is k_price + 1
+  const int k_demand = (t + 3599) / 3600; // demand of the whole hours left
+  if (k_price >= h_max) return 0.0;
+
+  // Water the tanks hold above their final level, which may serve any sink for free
+  Network *nw = p.getNetwork();
+  double volume = 0.0, volume_final = 0.0, volume_min = 0.0, surplus = 0.0;
+  for (size_t i = 0; i < tank_bounds.size(); ++i)
+  {
+    const double v = ((Tank *)nw->node(tank_bounds[i].index))->volume;
+    volume += v;
+    volume_final += lb_volume[i];
+    volume_min += lb_volume_min[i];
+    surplus += std::max(v - lb_volume[i], 0.0);
+  }
+
+  // Volume each tank is short of its final level and each monitored node still demands, at its own lift
+  const double *demand = lb_demand.data() + std::min(k_demand, h_max) * node_bounds.size();
+  double energy = 0.0;
+  for (const CostSink &sink : lb_sinks)
+  {
+    const double v = sink.tank ? std::max(lb_volume[sink.index] - ((Tank *)nw->node(tank_bounds[sink.index].index))->volume, 0.0)
+                               : demand[sink.index];
+    const double supplied = std::min(surplus, v);
+    surplus -= supplied;
+    energy += (v - supplied) * sink.energy;
+  }
+  double cost = energy * lb_price[k_price];
+
+  // Whole network balance: what the tanks cannot supply without dropping below level_min by the end of
+  // hour k is pumped during hours k_price + 1 .. k, and the tanks end at their final level
+  if (!lb_net_demand.empty())
+  {
+    double cost_min = std::numeric_limits<double>::max(), demand_sum = 0.0, pumped = 0.0, net = 0.0;
+    for (int k = k_price + 1; k <= h_max; ++k)
+    {
+      cost_min = std::min(cost_min, lb_net_cost[k]);
+      if (k > k_demand) demand_sum += lb_net_demand[k];
+      const double need = std::max(demand_sum - (volume - volume_min), 0.0);
+      net += (need - pumped) * cost_min;
+      pumped = need;
+    }
+    net += std::max(demand_sum + volume_final - volume - pumped, 0.0) * cost_min;
+    cost = std::max(cost, net);
+  }
+  return cost / 100.0; // prices are in cents
+}
+
 // Function to update pump speed patterns
 void BBConstraints::update_pumps(Project &p, const int h, const std::vector<int> &x, bool verbose)
 {
-  ProfileScope scope("update_pumps");
+  PROFILE_SCOPE("update_pumps");
 
   // Update pump speed patterns based on vector x
-  int j = 0;
   const size_t num_pumps = get_num_pumps();
   for (int i = 1; i <= h; i++)
   {
     const int *xi = &x[num_pumps * i];
-    j = 0; // Reset index of the pump pattern
-    for (auto &pump : pumps)
+    for (size_t j = 0; j < num_pumps; ++j)
     {
-      const auto &pump_name = pump.first;
-      const auto &pump_index = pump.second;
-      Pump *pump_link = (Pump *)p.getNetwork()->link(pump_index);
+      Pump *pump_link = (Pump *)p.getNetwork()->link(pump_index[j]);
       FixedPattern *pattern = dynamic_cast<FixedPattern *>(pump_link->speedPattern);
       if (!pattern)
       {
-        Console::printf(Console::Color::RED, "  Error: Pump %s does not have a FixedPattern speed pattern.\n", pump_name.c_str());
+        Console::printf(Console::Color::RED, "  Error: Pump %s does not have a FixedPattern speed pattern.\n", pump_names[j].c_str());
         continue;
       }
 
       // Retrieve new speed factor
-      double factor_new = static_cast<double>(xi[j++]);
+      double factor_new = static_cast<double>(xi[j]);
       // Retrieve old speed factor
       const int factor_id = i - 1; // pattern index is 0-based
       // Update speed factor
@@ -379,7 +672,7 @@ bool BBConstraints::check_timestep(int dt, bool verbose)
 
 BBPrune::Reason BBConstraints::check_feasibility(Project &p, int dt, const int h, double &cost, bool verbose)
 {
-  ProfileScope scope("check_feasibility");
+  PROFILE_SCOPE("check_feasibility");
   // This constraint is used in Cost2015 code. I'm not sure it's right. (TODO: check)
   // https://github.com/luishenrique-uva/branch-bound-epanet
   // commit 04a22c4f8eeb2909118910f70f5d74c3ef62f413
@@ -401,7 +694,7 @@ void BBConstraints::to_json(char *fn) const
   }
 
   nlohmann::json j;
-  j["best_cost"] = best_cost_local;
+  j["best_cost"] = best_cost_local.load();
   j["best_x"] = best_x;
   j["best_y"] = best_y;
   std::ofstream f(fn);
@@ -9,8 +9,10 @@
 #include "Elements/pump.h"
 #include "epanet3.h"
 
+#include <atomic>
 #include <map>
 #include <mpi.h>
+#include <mutex>
 #include <queue>
 #include <string>
 
@@ -27,7 +29,8 @@ public:
     STABILITY,
     COST,
     ACTUATIONS,
-    TIMESTEP
+    TIMESTEP,
+    DOMINANCE
   };
 
   static std::map<Reason, std::string> labels;
@@ -35,26 +38,66 @@ public:
 
 /**
  * @brief Class to handle constraint checking for branch and bound optimization
+ *
+ * The constraints are read from a JSON spec (see load_spec) and compiled into flat arrays of
+ * element indices and bounds, so the per-step checks are tight loops over the network data.
  */
 class BBConstraints
 {
 public:
-  std::map<std::string, int> nodes; ///< Map of node names to indices
-  std::map<std::string, int> tanks; ///< Map of tank names to indices
-  std::map<std::string, int> pumps; ///< Map of pump names to indices
+  /// Monitored node: pressure band (user units)
+  struct NodeBound
+  {
+    int index;
+    double pressure_min;
+    double pressure_max;
+  };
+
+  /// Constrained tank: head band and final head target (user units, -inf if none)
+  struct TankBound
+  {
+    int index;
+    double level_min;
+    double level_max;
+    double level_final;
+  };
+
+  std::vector<std::string> node_names; ///< IDs of the monitored nodes
+  std::vector<std::string> tank_names; ///< IDs of the constrained tanks
+  std::vector<std::string> pump_names; ///< IDs of the scheduled pumps (order of x)
+  std::vector<NodeBound> node_bounds;  ///< Pressure bounds (same order as node_names)
+  std::vector<TankBound> tank_bounds;  ///< Level bounds (same order as tank_names)
+  std::vector<int> pump_index;         ///< Link indices of the scheduled pumps
+  std::vector<int> cost_index;         ///< Link indices of the pumps whose energy cost is counted
   std::string inpFile;              ///< Path to input file
-  double best_cost_local;           ///< Local best cost
-  double best_cost_global;          ///< Global best cost
+  std::atomic<double> best_cost_local;  ///< Local best cost (shared by the worker threads)
+  std::atomic<double> best_cost_global; ///< Global best cost
   std::vector<int> best_x;          ///< Best pump statuses
   std::vector<int> best_y;          ///< Best pump speed patterns
   int hyd_timestep;                 ///< User-defined hydraulic timestep
-  MPI_Request request_nonblocking;
+  std::mutex best_mutex;            ///< Guards best_x/best_y updates from worker threads
+  MPI_Win win_best;                 ///< RMA window holding the global best cost (on rank 0)
+  double *win_base;                 ///< Local memory of win_best
 
   /**
-   * @brief Synchronizes the best solution found among all processes
+   * @brief Reads the global best cost from the RMA window (one atomic fetch from rank 0)
+   *
+   * The caller must hold the bb_mpi critical section (MPI_THREAD_SERIALIZED).
    */
   void sync_best();
 
+  /**
+   * @brief Publishes a local best cost to the RMA window (MPI_Accumulate with MPI_MIN)
+   *
+   * The caller must hold the bb_mpi critical section (MPI_THREAD_SERIALIZED).
+   */
+  void publish_best(double cost);
+
+  /**
+   * @brief Computes the exact global best cost and frees the RMA window (collective call)
+   */
+  void finish_sync();
+
   /**
    * @brief Constructs constraints checker for the given input file
    * @param inpFile Path to the EPANET input file
@@ -109,24 +152,61 @@ public:
   BBPrune::Reason check_feasibility(Project &p, int dt, const int h, double &cost, bool verbose);
 
   /**
-   * @brief Loads node and tank IDs from input file
+   * @brief Loads the prototype project from the input file
    * @param inpFile Path to the EPANET input file
    */
   void get_network_data(std::string inpFile);
 
+  /**
+   * @brief Reads the constraint spec and compiles it against the prototype network
+   *
+   * The spec is a JSON object:
+   * - "nodes": [{"id", "pressure_min", "pressure_max" (optional)}]
+   * - "tanks": [{"id", "level_min", "level_max", "level_final" (optional)}], levels are heads
+   * - "pumps": [id, ...], the scheduled pumps
+   * - "cost": {"pumps": [id, ...]} (optional), pumps whose energy cost is counted (default: "pumps")
+   * @param fn Path to the JSON file
+   */
+  void load_spec(const std::string &fn);
+
+  /**
+   * @brief Loads a project with an in-memory copy of the prototype network (no input file parsing)
+   * @param p Project to be loaded, its solver still has to be initialized
+   */
+  void clone_project(Project &p);
+
   /**
    * @brief Calculates total pump operation cost
    * @return Total operational cost
    */
   double calc_cost(Project &p) const;
 
+  /**
+   * @brief Reads the current tank levels
+   * @param levels Output array with one level per tank (in the order of tank_bounds)
+   */
+  void get_levels(Project &p, double *levels) const;
+
+  /**
+   * @brief Admissible lower bound on the pumping cost still needed from the current time to h_max
+   *
+   * The monitored nodes must get their remaining demand at no less than their minimum pressure, and
+   * the tanks must end at their final level, refilled at no less than their level_min; the water the
+   * tanks hold above their final level serves the dearest of these sinks for free. When the reservoirs
+   * only feed the network through scheduled pumps, all junction demand must also be pumped, in time to
+   * keep the tanks above level_min, at no less than the head of the pump curves. The larger of the two
+   * is priced at the best pump efficiency (see init_cost_bound).
+   * @return Lower bound (0 if disabled with --no_bound)
+   */
+  double cost_bound(Project &p) const;
+
   /**
    * @brief Gets number of nodes in network
    * @return Number of nodes
    */
   int get_num_nodes() const
   {
-    return (int)nodes.size();
+    return (int)node_bounds.size();
   }
 
   /**
@@ -135,7 +215,7 @@ public:
    */
   int get_num_tanks() const
   {
-    return (int)tanks.size();
+    return (int)tank_bounds.size();
   }
 
   /**
@@ -144,7 +224,7 @@ public:
    */
   int get_num_pumps() const
   {
-    return (int)pumps.size();
+    return (int)pump_index.size();
   }
 
   /**
@@ -176,7 +256,7 @@ public:
   void update_pumps(Project &p, const int h, const std::vector<int> &x, bool verbose);
 
   /**
-   * @brief Updates the best solution found
+   * @brief Updates the best solution found (thread-safe, ignores costs that are not improvements)
    * @param cost Cost of the new solution
    * @param x Pump statuses of the new solution
    * @param y Pump speed patterns of the new solution
@@ -217,4 +297,31 @@ private:
    * @param initial_level Initial tank level
    */
   void show_stability(bool is_feasible, const std::string &tank_name, double level, double initial_level);
+
+  /**
+   * @brief Precomputes the per-hour tables of cost_bound from the demand and price patterns
+   * @param config Branch-and-bound configuration (h_max, cost_bound)
+   */
+  void init_cost_bound(const BBConfig &config);
+
+  Project prototype; ///< Network parsed once from the input file, only read by the worker threads
+  double pcf;        ///< Pressure units conversion factor
+  double lcf;        ///< Length units conversion factor
+
+  /// Tank to refill or monitored node to supply in cost_bound
+  struct CostSink
+  {
+    int index;     ///< Index in tank_bounds or node_bounds
+    bool tank;     ///< Whether it is a tank
+    double energy; ///< Least pumping energy (kWh) per ft3 delivered to it
+  };
+
+  bool use_cost_bound;                ///< Prune on cost + cost_bound
+  std::vector<double> lb_demand;      ///< lb_demand[k * num_nodes + j]: volume (ft3) demanded at node j after hour k
+  std::vector<double> lb_price;       ///< lb_price[k]: cheapest energy price (per kWh) after hour k
+  std::vector<double> lb_net_demand;  ///< lb_net_demand[k]: volume (ft3) of all junction demands in hour k (empty: unused)
+  std::vector<double> lb_net_cost;    ///< lb_net_cost[k]: least cost (cents) per ft3 pumped from the reservoirs in hour k
+  std::vector<double> lb_volume;      ///< Volume (ft3) of each tank at its final level
+  std::vector<double> lb_volume_min;  ///< Volume (ft3) of each tank at its level_min
+  std::vector<CostSink> lb_sinks;     ///< Tanks and monitored nodes by decreasing energy (empty: no bound)
 };
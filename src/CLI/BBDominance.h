@@ -0,0 +1,120 @@
+// src/CLI/BBDominance.h
+#pragma once
+
+#include "CLI/BBConfig.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Per-rank transposition table for state-dominance pruning
+ *
+ * Different prefixes y[1..h] often reach the end of hour h with the same pump statuses, the same
+ * remaining actuations and nearly the same tank levels. The table is keyed by (h, quantized tank
+ * levels, remaining actuations, x[h]) and stores the cheapest cost seen at each key together with its
+ * exact tank levels. A partial schedule is dominated (and pruned) when a stored one with the same key
+ * is no more expensive and has every tank at least as full.
+ *
+ * The table has a fixed number of slots (config.tt_mb), grouped in buckets of WAYS slots. A new key
+ * takes an empty slot of its bucket or evicts the deepest entry, since entries close to the root
+ * prune larger subtrees. The worker threads of a process share the table.
+ */
+class BBDominance
+{
+public:
+  enum Result
+  {
+    MISS,  ///< key not in the table (the state was stored)
+    HIT,   ///< key found, the state is not dominated
+    PRUNE  ///< key found, the state is dominated
+  };
+
+  BBDominance(const BBConfig &config, int num_tanks, int num_pumps)
+      : num_tanks(num_tanks), num_pumps(num_pumps), tol(config.tt_tol)
+  {
+    if (!config.dominance) return;
+    const size_t slot_size = sizeof(Slot) + num_tanks * sizeof(double);
+    const size_t num_slots = ((size_t(config.tt_mb) << 20) / slot_size) / WAYS * WAYS;
+    slots.resize(num_slots);
+    levels.resize(num_slots * num_tanks);
+  }
+
+  bool enabled() const
+  {
+    return !slots.empty();
+  }
+
+  /**
+   * @brief Looks up the state at the end of hour h and stores it if it is not dominated
+   * @param h Hour of the state
+   * @param level Tank levels (num_tanks)
+   * @param x Pump statuses of hour h (num_pumps)
+   * @param allowed_01 Remaining off-on actuations of each pump
+   * @param allowed_10 Remaining on-off actuations of each pump
+   * @param cost Cost accumulated up to hour h
+   */
+  Result check(int h, const double *level, const int *x, const int *allowed_01, const int *allowed_10, double cost)
+  {
+    // key of the state
+    uint64_t key = mix(h);
+    for (int i = 0; i < num_tanks; ++i) key = mix(key ^ (uint64_t)(int64_t)std::floor(level[i] / tol));
+    for (int j = 0; j < num_pumps; ++j) key = mix(key ^ (uint64_t)((x[j] << 16) | (allowed_01[j] << 8) | allowed_10[j]));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t first = (key % (slots.size() / WAYS)) * WAYS;
+    size_t victim = first;
+    for (size_t k = first; k < first + WAYS; ++k)
+    {
+      Slot &slot = slots[k];
+      double *stored = &levels[k * num_tanks];
+      if (slot.h == h && slot.key == key)
+      {
+        bool below = true; // no tank fuller than in the stored state
+        for (int i = 0; i < num_tanks; ++i) below = below && (level[i] <= stored[i]);
+        if (cost >= slot.cost && below) return PRUNE;
+
+        // keep the cheaper representative of the key
+        if (cost < slot.cost)
+        {
+          slot.cost = cost;
+          std::copy(level, level + num_tanks, stored);
+        }
+        return HIT;
+      }
+      if (slots[victim].h != 0 && (slot.h == 0 || slot.h > slots[victim].h)) victim = k;
+    }
+
+    slots[victim] = {key, h, cost};
+    std::copy(level, level + num_tanks, &levels[victim * num_tanks]);
+    return MISS;
+  }
+
+private:
+  static constexpr size_t WAYS = 4;
+
+  struct Slot
+  {
+    uint64_t key = 0;
+    int h = 0; ///< hour of the state (0: empty slot)
+    double cost = 0.0;
+  };
+
+  static uint64_t mix(uint64_t z)
+  {
+    // splitmix64 finalizer
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  int num_tanks;
+  int num_pumps;
+  double tol;                 ///< quantization step of the tank levels in the key
+  std::vector<Slot> slots;
+  std::vector<double> levels; ///< exact tank levels of each slot
+  std::mutex mutex;
+};
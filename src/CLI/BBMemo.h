@@ -0,0 +1,195 @@
+// src/CLI/BBMemo.h
+#pragma once
+
+#include "CLI/BBConfig.h"
+
+#include "Core/project.h"
+#include "Elements/pump.h"
+#include "Elements/tank.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+class BBSibling;
+
+/**
+ * @brief Per-rank memo of one-hour simulations, keyed by (reduced state at the start of the hour, x of the hour)
+ *
+ * Apart from the warm start of the hydraulic solver, the simulation of hour h only depends on the
+ * tank volumes, the pattern periods and the time at the end of hour h-1 and on the pump statuses
+ * x[h]. The energy and cost accumulators of the pumps only add up, so they are left out of the key:
+ * an hour is simulated with cleared accumulators (see split_energy), its steps record the cost of
+ * the hour alone, and a hit replays them on top of the accumulators of the moment (see merge_energy).
+ * The stored result records the checks of every step (see BBSibling), so a hit is replayed against
+ * the incumbent of the moment as if the hour had been simulated again, from the flows of the first
+ * simulation instead of its own.
+ *
+ * Keys are a hash of the reduced state and x; a hit is only reported when both match exactly.
+ * The least recently used entries are evicted beyond config.memo_mb. The worker threads of a
+ * process share the memo.
+ */
+class BBMemo
+{
+public:
+  BBMemo(const BBConfig &config, int num_pumps) : num_pumps(num_pumps), memory_max(size_t(config.memo_mb) << 20)
+  {
+  }
+
+  bool enabled() const
+  {
+    return memory_max > 0;
+  }
+
+  /**
+   * @brief Reads the reduced state of a project: tank volumes, time and pattern periods
+   */
+  static void reduce(Project &p, std::vector<double> &state)
+  {
+    Network *nw = p.getNetwork();
+    state.clear();
+    for (Node *node : nw->nodes)
+      if (node->type() == Node::TANK) state.push_back(((Tank *)node)->volume);
+    state.push_back(p.getElapsedTime());
+    for (Pattern *pattern : nw->patterns) state.push_back(pattern->currentIdx());
+  }
+
+  /**
+   * @brief Copies a snapshot with its energy accumulators cleared (the state an hour is memoized from)
+   */
+  static void split_energy(const Network &nw, const ProjectData &state, ProjectData &hour)
+  {
+    hour = state;
+    PumpData *pumps = reinterpret_cast<PumpData *>(hour.data() + nw.dataLayout().pumps);
+    for (Link *link : nw.links)
+      if (link->type() == Link::PUMP) (pumps++)->pumpEnergy = PumpEnergyData();
+    reinterpret_cast<HydEngineData *>(hour.data() + hour.hydEngine)->peakKwatts = 0.0;
+  }
+
+  /**
+   * @brief Adds the energy accumulators of start to those of the end of a memoized hour
+   */
+  static void merge_energy(const Network &nw, const ProjectData &start, ProjectData &end)
+  {
+    const size_t offset = nw.dataLayout().pumps;
+    const PumpData *from = reinterpret_cast<const PumpData *>(start.data() + offset);
+    PumpData *to = reinterpret_cast<PumpData *>(end.data() + offset);
+    for (Link *link : nw.links)
+    {
+      if (link->type() != Link::PUMP) continue;
+      const PumpEnergyData &a = (from++)->pumpEnergy;
+      PumpEnergyData &b = (to++)->pumpEnergy;
+      // time weighted averages (see PumpEnergy::updateEnergyUsage)
+      const double hrs = a.hrsOnLine + b.hrsOnLine;
+      auto average = [&](double x, double y) { return (hrs > 0.0) ? (x * a.hrsOnLine + y * b.hrsOnLine) / hrs : 0.0; };
+      b.efficiency = average(a.efficiency, b.efficiency);
+      b.kwHrs = average(a.kwHrs, b.kwHrs);
+      b.kwHrsPerCFS = average(a.kwHrsPerCFS, b.kwHrsPerCFS);
+      b.totalCost = average(a.totalCost, b.totalCost);
+      b.hrsOnLine = hrs;
+      b.maxKwatts = std::max(a.maxKwatts, b.maxKwatts);
+      b.adjustedTotalCost += a.adjustedTotalCost;
+    }
+    const HydEngineData *a = reinterpret_cast<const HydEngineData *>(start.data() + start.hydEngine);
+    HydEngineData *b = reinterpret_cast<HydEngineData *>(end.data() + end.hydEngine);
+    b->peakKwatts = std::max(a->peakKwatts, b->peakKwatts);
+  }
+
+  /**
+   * @brief Looks up the outcome of simulating the hour from the reduced state with pump statuses x
+   * @return Stored outcome, or nullptr if the pair is not in the memo
+   */
+  std::shared_ptr<const BBSibling> find(const std::vector<double> &state, const int *x)
+  {
+    const uint64_t key = hash(state, x);
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it == index.end() || !matches(*it->second, state, x)) return nullptr;
+    entries.splice(entries.begin(), entries, it->second); // most recently used
+    return it->second->result;
+  }
+
+  /**
+   * @brief Stores the outcome of simulating the hour from the reduced state with pump statuses x
+   * @param bytes Memory held by the outcome
+   */
+  void insert(const std::vector<double> &state, const int *x, std::shared_ptr<const BBSibling> result, size_t bytes)
+  {
+    const uint64_t key = hash(state, x);
+    const size_t entry_memory = sizeof(Entry) + state.size() * sizeof(double) + num_pumps * sizeof(int) + bytes;
+    if (entry_memory > memory_max) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = index.find(key);
+    if (it != index.end()) erase(it->second); // same pair (another thread) or a hash collision
+
+    while (memory + entry_memory > memory_max) erase(std::prev(entries.end()));
+
+    entries.emplace_front();
+    Entry &entry = entries.front();
+    entry.key = key;
+    entry.state = state;
+    entry.x.assign(x, x + num_pumps);
+    entry.result = std::move(result);
+    entry.memory = entry_memory;
+    index[key] = entries.begin();
+    memory += entry_memory;
+  }
+
+private:
+  struct Entry
+  {
+    uint64_t key;
+    std::vector<double> state;               ///< reduced state at the start of the hour
+    std::vector<int> x;                      ///< pump statuses of the hour
+    std::shared_ptr<const BBSibling> result; ///< outcome of the hour
+    size_t memory;                           ///< bytes counted for the entry
+  };
+
+  static uint64_t mix(uint64_t z)
+  {
+    // splitmix64 finalizer
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t hash(const std::vector<double> &state, const int *x) const
+  {
+    uint64_t key = 0;
+    for (double value : state)
+    {
+      uint64_t word;
+      std::memcpy(&word, &value, sizeof(word));
+      key = mix(key ^ word);
+    }
+    for (int j = 0; j < num_pumps; ++j) key = mix(key ^ (uint64_t)x[j]);
+    return key;
+  }
+
+  bool matches(const Entry &entry, const std::vector<double> &state, const int *x) const
+  {
+    return entry.state == state && std::equal(entry.x.begin(), entry.x.end(), x);
+  }
+
+  void erase(std::list<Entry>::iterator it)
+  {
+    memory -= it->memory;
+    index.erase(it->key);
+    entries.erase(it);
+  }
+
+  int num_pumps;
+  size_t memory_max;        ///< memory cap of the entries (bytes)
+  size_t memory = 0;        ///< memory of the entries (bytes)
+  std::list<Entry> entries; ///< most recently used first
+  std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+  std::mutex mutex;
+};
@@ -0,0 +1,122 @@
+// src/CLI/BBPrefix.h
+#pragma once
+
+#include "CLI/BBConfig.h"
+#include "CLI/BBConstraints.h"
+
+#include "Core/project.h"
+
+#include <mutex>
+#include <vector>
+
+using Epanet::Project;
+
+/**
+ * @brief Per-rank trie of the simulated task prefixes y[1..k]
+ *
+ * The tasks created by populate_tasks only differ in y[1..level], so their initial simulations
+ * (hours 1..h_root-1) share most hours. Each trie node holds the outcome of one prefix: the state
+ * at the end of its last hour, or the reason it was pruned. A task resumes from the state of its
+ * deepest stored prefix. If one of its prefixes was pruned, the whole task group below that prefix
+ * is pruned without simulating anything.
+ *
+ * States are stored until the trie holds config.prefix_mb; after that, only prune reasons are added.
+ * The worker threads of a process share the trie.
+ */
+class BBPrefixTrie
+{
+public:
+  BBPrefixTrie(const BBConfig &config, int num_pumps)
+      : num_children(num_pumps + 1), memory_max(size_t(config.prefix_mb) << 20)
+  {
+    nodes.emplace_back();
+    children.assign(num_children, -1);
+  }
+
+  bool enabled() const
+  {
+    return memory_max > 0;
+  }
+
+  /**
+   * @brief Loads the state of the deepest stored prefix of y[1..h] into the project
+   * @param reason Set to the prune reason if a prefix of y[1..h] is known to be infeasible
+   * @return Last hour of the loaded prefix (0 if none was loaded)
+   */
+  int load(Project &p, const std::vector<int> &y, int h, BBPrune::Reason &reason)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    reason = BBPrune::Reason::NONE;
+    int node = 0, h_state = 0, node_state = -1;
+    for (int k = 1; k <= h; ++k)
+    {
+      node = children[node * num_children + y[k]];
+      if (node < 0) break;
+      if (nodes[node].reason != BBPrune::Reason::NONE)
+      {
+        reason = nodes[node].reason;
+        return 0;
+      }
+      if (nodes[node].state.size() > 0)
+      {
+        h_state = k;
+        node_state = node;
+      }
+    }
+    if (node_state >= 0) p.copy_from(nodes[node_state].state);
+    return h_state;
+  }
+
+  /**
+   * @brief Stores the current state of the project as the state of the prefix y[1..h]
+   */
+  void store(Project &p, const std::vector<int> &y, int h)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    Node &node = nodes[insert(y, h)];
+    if (node.state.size() > 0 || memory + p.dataSize() > memory_max) return;
+    p.copy_to(node.state);
+    memory += node.state.size();
+  }
+
+  /**
+   * @brief Records that the prefix y[1..h] was pruned (and so is every task below it)
+   */
+  void prune(const std::vector<int> &y, int h, BBPrune::Reason reason)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    nodes[insert(y, h)].reason = reason;
+  }
+
+private:
+  struct Node
+  {
+    ProjectData state;                              ///< state at the end of the last hour (empty if not stored)
+    BBPrune::Reason reason = BBPrune::Reason::NONE; ///< why the prefix was pruned
+  };
+
+  // Returns the node of y[1..h], creating the missing ones
+  int insert(const std::vector<int> &y, int h)
+  {
+    int node = 0;
+    for (int k = 1; k <= h; ++k)
+    {
+      int &child = children[node * num_children + y[k]];
+      if (child < 0)
+      {
+        child = (int)nodes.size();
+        nodes.emplace_back();
+        children.resize(children.size() + num_children, -1);
+      }
+      node = children[node * num_children + y[k]]; // children may have been reallocated
+    }
+    return node;
+  }
+
+  int num_children;          ///< y[k] takes values 0..num_pumps
+  size_t memory_max;         ///< memory cap of the stored states (bytes)
+  size_t memory = 0;         ///< memory of the stored states (bytes)
+  std::vector<Node> nodes;   ///< nodes[0] is the empty prefix
+  std::vector<int> children; ///< children[node * num_children + y]: child node (-1 if absent)
+  std::mutex mutex;
+};
@@ -0,0 +1,72 @@
+// src/CLI/BBScheduler.cpp
+#include "BBScheduler.h"
+#include "Profiler.h"
+
+#include <stdexcept>
+
+BBScheduler::Mode BBScheduler::parse_mode(const std::string &name)
+{
+  if (name == "static") return STATIC;
+  if (name == "dynamic") return DYNAMIC;
+  throw std::runtime_error("BBScheduler: unknown schedule '" + name + "' (expected static|dynamic)");
+}
+
+BBScheduler::BBScheduler(const BBConfig &config, int num_tasks) : num_tasks(num_tasks), counter(nullptr)
+{
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+
+  mode = parse_mode(config.schedule);
+  uid_static = rank;
+
+  if (mode == DYNAMIC)
+  {
+    // The counter lives on rank 0, the other processes expose an empty window
+    MPI_Aint size = (rank == 0) ? sizeof(int) : 0;
+    MPI_Win_allocate(size, sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &counter, &win);
+    if (rank == 0) *counter = 0;
+    // Make the initialization visible before anyone fetches
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(0, win);
+  }
+}
+
+BBScheduler::~BBScheduler()
+{
+  finalize();
+}
+
+int BBScheduler::next()
+{
+  PROFILE_TRACE_SCOPE("scheduler");
+
+  int uid = -1;
+  if (mode == STATIC)
+  {
+    if (uid_static < num_tasks)
+    {
+      uid = uid_static;
+      uid_static += num_procs;
+    }
+  }
+  else
+  {
+    const int one = 1;
+    int fetched;
+    MPI_Fetch_and_op(&one, &fetched, MPI_INT, 0, 0, MPI_SUM, win);
+    MPI_Win_flush(0, win);
+    if (fetched < num_tasks) uid = fetched;
+  }
+
+  if (uid >= 0) ++num_fetched;
+  return uid;
+}
+
+void BBScheduler::finalize()
+{
+  if (win == MPI_WIN_NULL) return;
+  MPI_Win_unlock_all(win);
+  MPI_Win_free(&win);
+  win = MPI_WIN_NULL;
+  counter = nullptr;
+}
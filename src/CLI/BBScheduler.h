@@ -0,0 +1,65 @@
+// src/CLI/BBScheduler.h
+#pragma once
+
+#include "CLI/BBConfig.h"
+
+#include <mpi.h>
+#include <string>
+
+/**
+ * @brief Distributes branch-and-bound tasks among the MPI processes
+ *
+ * Every process holds the same (deterministically generated) task list, so only task indices are exchanged.
+ * In static mode the task uid is assigned round-robin (uid % num_procs). In dynamic mode the processes
+ * share a task counter stored in an MPI-3 RMA window on rank 0: an idle process atomically fetches and
+ * increments it, so slow subtrees no longer leave the other processes waiting. The search terminates when
+ * the counter exceeds the number of tasks, which every process observes on its own (no extra messages).
+ */
+class BBScheduler
+{
+public:
+  enum Mode
+  {
+    STATIC,
+    DYNAMIC
+  };
+
+  /**
+   * @brief Creates the scheduler (collective call in dynamic mode)
+   * @param config Branch-and-bound configuration (schedule mode)
+   * @param num_tasks Number of tasks generated by populate_tasks
+   */
+  BBScheduler(const BBConfig &config, int num_tasks);
+  ~BBScheduler();
+
+  /**
+   * @brief Gets the index of the next task to be processed by this process
+   * @return Task index or -1 if all tasks have been handed out
+   */
+  int next();
+
+  /**
+   * @brief Releases the RMA window (collective call, must precede MPI_Finalize)
+   */
+  void finalize();
+
+  /**
+   * @brief Number of tasks handed to this process so far
+   */
+  int get_num_fetched() const
+  {
+    return num_fetched;
+  }
+
+  static Mode parse_mode(const std::string &name);
+
+private:
+  Mode mode;
+  int num_tasks;
+  int num_fetched = 0;
+  int rank;
+  int num_procs;
+  int uid_static; ///< next candidate uid in static mode
+  int *counter;   ///< shared task counter (only meaningful on rank 0)
+  MPI_Win win = MPI_WIN_NULL;
+};
@@ -3,7 +3,11 @@
 
 #include "BBConfig.h"
 #include "BBConstraints.h"
+#include "BBDominance.h"
+#include "BBMemo.h"
+#include "BBPrefix.h"
 #include "BBStatistics.h"
+#include "BBTrail.h"
 #include "Console.h"
 #include "Profiler.h"
 
@@ -12,6 +16,8 @@
 #include "Elements/tank.h"
 
 #include <algorithm>
+#include <chrono>
+#include <memory>
 #include <queue>
 #include <stdexcept>
 #include <vector>
@@ -29,7 +35,7 @@ public:
   int uid;
   int h_root; // first hour that can be changed
   double cost;
-  std::vector<ProjectData> snapshots;
+  BBTrail trail; // states along the current branch (undo log)
   std::vector<int> y;
   std::vector<int> x;
   int h;
@@ -87,6 +93,63 @@ public:
   }
 };
 
+//---------------------------------------------------------------------
+// BBNode: A partial schedule (y[1..h], x) waiting in the best-first open list.
+//---------------------------------------------------------------------
+class BBNode
+{
+public:
+  int h;             // last scheduled hour
+  double cost;       // cost accumulated up to hour h
+  double bound;      // lower bound on the cost of the remaining hours
+  std::vector<int> y;
+  std::vector<int> x;
+  ProjectData state; // simulation state at the end of hour h
+
+  double priority() const
+  {
+    return cost + bound;
+  }
+
+  bool operator<(const BBNode &other) const
+  {
+    return priority() > other.priority(); // Lower cost (plus bound) comes first
+  }
+
+  size_t memory() const
+  {
+    return sizeof(BBNode) + state.size() + (y.size() + x.size()) * sizeof(int);
+  }
+};
+
+//---------------------------------------------------------------------
+// BBSibling: Outcome of one child y[h] = k, simulated ahead of its turn in the DFS (--siblings).
+// The checks of every hydraulic step are recorded so that the outcome can be replayed against the
+// incumbent of the moment the DFS reaches the child, as if it had been simulated then.
+//---------------------------------------------------------------------
+class BBSibling
+{
+public:
+  struct Step
+  {
+    BBPrune::Reason before_cost; // LEVELS or TIMESTEP (checked before the cost)
+    double cost;                 // cost at the end of the step
+    double bound;                // lower bound on the remaining cost
+    BBPrune::Reason after_cost;  // PRESSURES (checked after the cost)
+  };
+
+  bool simulated = false;                             // false if x is not feasible (ACTUATIONS)
+  std::vector<Step> steps;                            // checks of each hydraulic step, up to the first failure
+  bool completed = false;                             // the hour was simulated to its end
+  BBPrune::Reason stability = BBPrune::Reason::NONE;  // result of check_stability (last hour only)
+  ProjectData state;                                  // state at the end of the hour (if completed)
+
+  size_t memory() const
+  {
+    return sizeof(BBSibling) + steps.size() * sizeof(Step) + state.size();
+  }
+};
+
 //---------------------------------------------------------------------
 // BBPumpController: Manages pump switching logic.
 //---------------------------------------------------------------------
@@ -170,10 +233,28 @@ public:
 class BBSolver
 {
 public:
+  enum Search
+  {
+    DFS,        // depth-first enumeration of y in increasing order
+    BEST_FIRST, // open list ordered by cost plus lower bound
+    HYBRID      // depth-first dive up to the first incumbent, then best-first
+  };
+
   // Constructor can take config and constraints references
-  BBSolver(BBConfig &configRef, BBConstraints &constraintsRef, BBStatistics &statsRef)
-      : config(configRef), constraints(constraintsRef), stats(statsRef)
+  BBSolver(BBConfig &configRef, BBConstraints &constraintsRef, BBStatistics &statsRef, BBDominance &dominanceRef,
+           BBPrefixTrie &prefixesRef, BBMemo &memoRef)
+      : config(configRef), constraints(constraintsRef), stats(statsRef), dominance(dominanceRef), prefixes(prefixesRef),
+        memo(memoRef)
+  {
+    search = parse_search(config.search);
+  }
+
+  static Search parse_search(const std::string &name)
   {
+    if (name == "dfs") return DFS;
+    if (name == "best-first") return BEST_FIRST;
+    if (name == "hybrid") return HYBRID;
+    throw std::runtime_error("BBSolver: unknown search '" + name + "' (expected dfs|best-first|hybrid)");
   }
 
   // Orchestrates the BBTask solution process
@@ -190,9 +271,78 @@ public:
     if (prune_reason != BBPrune::Reason::NONE)
     {
       if (config.verbose) stats.show();
-      return;
     }
+    else if (search == DFS)
+      searchDFS(task);
+    else
+      searchBestFirst(task);
+
+    // the tasks outlive their search, so release the states along the last branch
+    task.trail.clear();
+  }
+
+  //---------------------------------------------------------------------
+  // Primal heuristic run before the branch-and-bound: a greedy dive (children ordered by cost plus
+  // lower bound, backtracking on dead ends) gives a first feasible schedule, then a local search
+  // moves y[h] by +-1 while it finds cheaper schedules. Each improvement goes through update_best.
+  // Returns false if no feasible schedule was found within the time budget (seconds).
+  //---------------------------------------------------------------------
+  bool solveHeuristic(double time_budget)
+  {
+    PROFILE_SCOPE("solveHeuristic");
+    deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                       std::chrono::duration<double>(time_budget));
+    warm_start = true;
+
+    Project p;
+    BBTask task(-1, config, constraints);
+    MPI_Comm_rank(MPI_COMM_WORLD, &task.tid);
+    task.p = &p;
+    task.cost = std::numeric_limits<double>::max();
+    task.x.resize((config.h_max + 1) * task.num_pumps, 0);
+    task.is_feasible = true;
+    if (initSnapshots(task) != BBPrune::Reason::NONE) return false;
+
+    BBNode root;
+    root.h = 0;
+    root.cost = 0.0;
+    root.y = task.y;
+    root.x = task.x;
+    task.trail.restore(p, 0);
+    p.copy_to(root.state);
+    root.bound = constraints.cost_bound(p);
+
+    // states at the end of hours 0 .. h_max - 1 of the incumbent
+    std::vector<ProjectData> states;
+    if (!dive(task, root, states)) return false;
+
+    localSearch(task, states);
+    return true;
+  }
+
+private:
+  int niters = 0; // hydraulic steps simulated by this solver
+  bool warm_start = false; // solveHeuristic is running (no dominance pruning)
+  std::vector<std::unique_ptr<Project>> replicas; // one project per child of the sibling mode
+  std::vector<std::vector<BBSibling>> siblings;   // siblings[h][k]: child y[h] = k of the current parent
+  std::vector<std::vector<int>> siblings_parent;  // siblings_parent[h]: y[1..h-1] of the parent of siblings[h]
+  ProjectData memo_state;                         // state at the start of the hour looked up in the memo
+  ProjectData memo_hour;                          // the same state with cleared energy accumulators, or the end of the hour
+  std::vector<double> memo_key;                   // reduced state at the start of the hour (BBMemo::reduce)
+  std::chrono::steady_clock::time_point deadline;
+  BBConfig &config;
+  BBConstraints &constraints;
+  BBStatistics &stats;
+  BBDominance &dominance;
+  BBPrefixTrie &prefixes;
+  BBMemo &memo;
+  Search search;
 
+  //---------------------------------------------------------------------
+  // Depth-first search of the subtree below task.h_root - 1 (state on the trail)
+  //---------------------------------------------------------------------
+  void searchDFS(BBTask &task)
+  {
     // branch-and-bound loop
     while (true)
     {
@@ -222,11 +372,208 @@ public:
     }
   }
 
-private:
-  int niters = 0;
-  BBConfig &config;
-  BBConstraints &constraints;
-  BBStatistics &stats;
+  //---------------------------------------------------------------------
+  // Best-first search of the subtree below task.h_root - 1: the open list holds the feasible
+  // partial schedules (with their states) ordered by cost plus lower bound. When the open list
+  // reaches its memory cap, the selected nodes are solved by DFS instead of being expanded.
+  //---------------------------------------------------------------------
+  void searchBestFirst(BBTask &task)
+  {
+    PROFILE_SCOPE("searchBestFirst");
+    Project &p = *(task.p);
+    const size_t open_max = size_t(config.open_mb) << 20;
+    size_t open_memory = 0;
+    std::priority_queue<BBNode> open;
+
+    // root node
+    BBNode root;
+    root.h = task.h_root - 1;
+    root.cost = (root.h == 0) ? 0.0 : task.cost;
+    root.y = task.y;
+    root.x = task.x;
+    task.trail.restore(p, root.h);
+    p.copy_to(root.state);
+    root.bound = constraints.cost_bound(p);
+
+    BBNode node = std::move(root);
+    bool has_node = true;
+    while (has_node || !open.empty())
+    {
+      if (!has_node)
+      {
+        node = open.top();
+        open.pop();
+        open_memory -= node.memory();
+      }
+      has_node = false;
+
+      // the incumbent may have improved since the node was created
+      if (node.priority() >= best_cost())
+      {
+        stats.add_stats(BBPrune::Reason::COST, node.h + 1);
+        continue;
+      }
+
+      // memory cap reached: the subtree is solved depth-first
+      if (open_memory + node.memory() > open_max)
+      {
+        solveDFS(task, node);
+        continue;
+      }
+
+      // expand the node: one child per y[h + 1]
+      std::vector<BBNode> children;
+      expand(task, node, children);
+
+      // dive into the cheapest child while there is no incumbent
+      auto cheapest = std::min_element(children.begin(), children.end(),
+                                       [](const BBNode &a, const BBNode &b) { return a.priority() < b.priority(); });
+      if (search == HYBRID && cheapest != children.end() && best_cost() == std::numeric_limits<double>::max())
+      {
+        node = std::move(*cheapest);
+        children.erase(cheapest);
+        has_node = true;
+      }
+
+      for (BBNode &child : children)
+      {
+        open_memory += child.memory();
+        open.push(std::move(child));
+      }
+    }
+  }
+
+  // Simulates hour node.h + 1 for every y[node.h + 1] and returns the feasible children
+  void expand(BBTask &task, const BBNode &node, std::vector<BBNode> &children)
+  {
+    Project &p = *(task.p);
+    task.h = node.h + 1;
+    task.y = node.y;
+    task.x = node.x;
+    for (task.y[task.h] = 0; task.y[task.h] <= task.num_pumps; ++task.y[task.h])
+    {
+      updateX(task);
+      if (!task.is_feasible)
+      {
+        stats.add_stats(BBPrune::Reason::ACTUATIONS, task.h);
+        continue;
+      }
+
+      if (config.verbose)
+      {
+        Console::hline(Console::Color::BRIGHT_YELLOW, 20);
+        Console::printf(Console::Color::BRIGHT_YELLOW, "TID[%d]: expand: h=%d, cost=%.2f\n", task.tid, task.h, node.cost);
+        task.show_xy(true);
+      }
+
+      p.copy_from(node.state);
+      BBPrune::Reason prune_reason = solveHour(task); // COST jumps y[h] to the end
+      if (prune_reason == BBPrune::Reason::NONE) prune_reason = checkDominance(task);
+      stats.add_stats(prune_reason, task.h);
+
+      if (task.is_feasible && task.h < config.h_max)
+      {
+        BBNode child;
+        child.h = task.h;
+        child.cost = task.cost;
+        child.bound = constraints.cost_bound(p);
+        child.y = task.y;
+        child.x = task.x;
+        p.copy_to(child.state);
+        children.push_back(std::move(child));
+      }
+    }
+  }
+
+  // Greedy dive of the heuristic: returns true once a schedule cheaper than the incumbent is found,
+  // with the states at the end of hours 0 .. h_max - 1 of that schedule in path
+  bool dive(BBTask &task, const BBNode &node, std::vector<ProjectData> &path)
+  {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    path.push_back(node.state); // the children of the callers are freed once the dive returns
+
+    const double best = constraints.best_cost_local;
+    std::vector<BBNode> children;
+    expand(task, node, children); // the last hour updates the incumbent
+    if (constraints.best_cost_local < best) return true;
+
+    std::sort(children.begin(), children.end(), [](const BBNode &a, const BBNode &b) { return a.priority() < b.priority(); });
+    for (const BBNode &child : children)
+    {
+      if (dive(task, child, path)) return true;
+    }
+    path.pop_back();
+    return false;
+  }
+
+  // Local search of the heuristic (first improvement, last hours first): y[h] += dy alone, or
+  // together with y[k] -= dy for a later hour k (moves pumping between hours)
+  void localSearch(BBTask &task, std::vector<ProjectData> &states)
+  {
+    std::vector<ProjectData> candidate(config.h_max);
+    bool improved = true;
+    while (improved)
+    {
+      improved = false;
+      for (int h = config.h_max; h >= 1 && !improved; --h)
+      {
+        for (int k = h; k <= config.h_max && !improved; ++k)
+        {
+          for (int dy : {-1, 1})
+          {
+            if (std::chrono::steady_clock::now() > deadline) return;
+            task.y = constraints.best_y;
+            task.x = constraints.best_x;
+            task.y[h] += dy;
+            if (k > h) task.y[k] -= dy;
+            if (task.y[h] < 0 || task.y[h] > task.num_pumps || task.y[k] < 0 || task.y[k] > task.num_pumps) continue;
+
+            const double best = constraints.best_cost_local;
+            if (!simulate(task, h, states[h - 1], candidate) || constraints.best_cost_local >= best) continue;
+
+            // the incumbent changed from hour h on
+            for (int i = h; i < config.h_max; ++i) std::swap(states[i], candidate[i]);
+            improved = true;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  // Simulates hours h .. h_max of task.y from the given state (end of hour h - 1), keeping the states
+  bool simulate(BBTask &task, int h, const ProjectData &state, std::vector<ProjectData> &states)
+  {
+    task.p->copy_from(state);
+    for (task.h = h; task.h <= config.h_max; ++task.h)
+    {
+      updateX(task);
+      if (!task.is_feasible) return false;
+      if (solveHour(task) != BBPrune::Reason::NONE) return false;
+      if (task.h < config.h_max) task.p->copy_to(states[task.h]);
+    }
+    return true;
+  }
+
+  // Depth-first search of the subtree of an open node
+  void solveDFS(BBTask &task, const BBNode &node)
+  {
+    task.h = node.h;
+    task.h_root = node.h + 1;
+    task.y = node.y;
+    task.x = node.x;
+    task.cost = node.cost;
+    task.is_feasible = true;
+    task.p->copy_from(node.state);
+    task.trail.init(*task.p, node.h);
+    searchDFS(task);
+  }
+
+  double best_cost() const
+  {
+    return std::min(constraints.best_cost_local.load(), constraints.best_cost_global.load());
+  }
+
   //---------------------------------------------------------------------
   // Helper function for tasks initialization
   //---------------------------------------------------------------------
@@ -238,9 +585,9 @@ private:
       Console::printf(Console::Color::BRIGHT_YELLOW, "TID[%d]: initSnapshots: task.h_root=%d\n", task.tid, task.h_root);
     }
 
-    // load project
+    // load project (copy of the network parsed by the constraints)
     Project &p = *(task.p);
-    p.load(config.inpFile.c_str());
+    constraints.clone_project(p);
     Network *nw = p.getNetwork();
     int t_max = 3600 * config.h_max;
     nw->options.setOption(Options::TimeOption::TOTAL_DURATION, t_max);
@@ -255,16 +602,28 @@ private:
       updatePumps(task, false);
     }
 
-    // copy snapshots
-    task.snapshots.resize(config.h_max + 1);
-    p.copy_to(task.snapshots[0]);
+    // the trail starts at the root state, i.e., the end of hour h_root - 1
+    task.trail.init(p, 0);
 
-    // run solver to copy snapshots
     int t, dt, t_new;
     task.h = 0;
-
-    // run solver to copy snapshots
     BBPrune::Reason prune_reason = BBPrune::Reason::NONE;
+
+    // resume from the deepest prefix y[1..h] simulated by a previous task
+    const bool share_prefixes = prefixes.enabled() && task.h_root > 1;
+    if (share_prefixes)
+    {
+      task.h = prefixes.load(p, task.y, task.h_root - 1, prune_reason);
+      if (prune_reason != BBPrune::Reason::NONE) return prune_reason;
+      task.cost = constraints.calc_cost(p);
+      if (task.h == task.h_root - 1)
+      {
+        task.trail.init(p, task.h);
+        return prune_reason;
+      }
+    }
+
+    // run solver up to the root state
     do
     {
       CHK(p.runSolver(&t), "Run solver");
@@ -284,18 +643,23 @@ private:
       if (prune_reason != BBPrune::Reason::NONE)
       {
         stats.add_stats(prune_reason, task.h + 1);
+        if (share_prefixes) prefixes.prune(task.y, task.h + 1, prune_reason); // prunes the whole task group
         return prune_reason;
       }
 
       if (t_new % 3600 == 0)
       {
-        ProfileScope scope("initSnapshots");
         task.h = t_new / 3600; // update hour
-        p.copy_to(task.snapshots[task.h]);
+        if (share_prefixes) prefixes.store(p, task.y, task.h);
+        if (task.h == task.h_root - 1)
+        {
+          PROFILE_TRACE_SCOPE("initSnapshots");
+          task.trail.init(p, task.h);
+        }
 
         stats.add_stats(prune_reason, task.h);
       }
-    } while (task.h < (task.h_root - 1)); // initialize the snapshots for hours up to h_root
+    } while (task.h < (task.h_root - 1)); // initialize the state for hours up to h_root
 
     return prune_reason;
   }
@@ -324,8 +688,8 @@ private:
         task.is_feasible = true;
         return;
       }
-      // No more increments, backtrack
-      --task.h;
+      // No more increments, backtrack (unless the root is the last level)
+      if (task.h > task.h_root) --task.h;
       task.is_feasible = false;
       updateY(task);
       return;
@@ -423,22 +787,31 @@ private:
   //===============================================================
   BBPrune::Reason processLevel(BBTask &task)
   {
+    PROFILE_TRACE_SCOPE("processLevel");
+    PROFILE_ANNOTATE("h", task.h);
     if (config.verbose)
     {
       Console::hline(Console::Color::BRIGHT_YELLOW, 20);
       Console::printf(Console::Color::BRIGHT_YELLOW, "TID[%d]: processLevel: h=%d\n", task.tid, task.h);
     }
 
-    // load previous state
-    task.p->copy_from(task.snapshots[task.h - 1]);
-
-    updatePumps(task, false);
-    BBPrune::Reason prune_reason = epanetSolve(task);
+    BBPrune::Reason prune_reason;
+    if (config.siblings > 1)
+    {
+      prune_reason = siblingSolve(task);
+    }
+    else
+    {
+      // load previous state (backtracking the trail if needed)
+      task.trail.restore(*task.p, task.h - 1);
+      prune_reason = solveHour(task);
+    }
+    if (prune_reason == BBPrune::Reason::NONE) prune_reason = checkDominance(task);
 
-    // copy current state to snapshot
+    // record the changes of the current state in the trail
     if (task.is_feasible) {
-      ProfileScope scope("processLevel");
-      task.p->copy_to(task.snapshots[task.h]);
+      PROFILE_SCOPE("trail_save");
+      task.trail.save(*task.p, task.h);
     }
 
     return prune_reason;
@@ -466,7 +839,7 @@ private:
   //===============================================================
   BBPrune::Reason epanetSolve(BBTask &task)
   {
-    ProfileScope scope("epanetSolve");
+    PROFILE_TRACE_SCOPE("epanetSolve");
 
     const int t_min = 3600 * (task.h - 1);
     const int t_max = 3600 * task.h;
@@ -481,6 +854,13 @@ private:
 
       t_new = t + dt;
 
+      // poll the global best cost so that check_cost prunes with a near-current incumbent
+      if (config.sync_steps > 0 && ++niters % config.sync_steps == 0)
+      {
+#pragma omp critical(bb_mpi)
+        constraints.sync_best();
+      }
+
       if (config.verbose)
       {
         int h = std::min(t_new / 3600 + 1, task.h);
@@ -517,7 +897,7 @@ private:
           if (constraints.best_cost_local == std::numeric_limits<double>::max())
             snprintf(fmt_cost_ub, sizeof(fmt_cost_ub), "inf");
           else
-            snprintf(fmt_cost_ub, sizeof(fmt_cost_ub), "%.2f", constraints.best_cost_local);
+            snprintf(fmt_cost_ub, sizeof(fmt_cost_ub), "%.2f", constraints.best_cost_local.load());
           // Show old and new cost
           Console::printf(Console::Color::BRIGHT_GREEN, "TID[%d]: cost update: 💰 cost=%.2f, cost_ub=%s\n", task.tid, task.cost, fmt_cost_ub);
         }
@@ -529,11 +909,236 @@ private:
 
     return prune_reason;
   }
+
+  // Simulates hour task.h from the state of the project, through the memo if enabled
+  BBPrune::Reason solveHour(BBTask &task)
+  {
+    updatePumps(task, false);
+    return memo.enabled() ? memoSolve(task) : epanetSolve(task);
+  }
+
+  //===============================================================
+  // 5b) Sibling mode: simulates all children of the parent at once, then replays the current one
+  //===============================================================
+  BBPrune::Reason siblingSolve(BBTask &task)
+  {
+    const int h = task.h;
+    if (siblings.empty())
+    {
+      siblings.resize(config.h_max + 1);
+      siblings_parent.resize(config.h_max + 1);
+    }
+
+    // load previous state (backtracking the trail if needed)
+    task.trail.restore(*task.p, h - 1);
+    if (siblings[h].empty() || !std::equal(task.y.begin() + 1, task.y.begin() + h, siblings_parent[h].begin()))
+      simulateSiblings(task);
+    return replaySibling(task, siblings[h][task.y[h]]);
+  }
+
+  // Simulates hour task.h of every child y[h] = 0..num_pumps of the parent (one thread per child)
+  void simulateSiblings(BBTask &task)
+  {
+    PROFILE_SCOPE("simulateSiblings");
+    const int h = task.h;
+    const int num_children = task.num_pumps + 1;
+
+    if (replicas.empty())
+    {
+      for (int k = 0; k < num_children; ++k)
+      {
+        replicas.emplace_back(new Project);
+        Project &q = *replicas.back();
+        constraints.clone_project(q);
+        q.getNetwork()->options.setOption(Options::TimeOption::TOTAL_DURATION, 3600 * config.h_max);
+        CHK(q.initSolver(EN_INITFLOW), "Init solver");
+      }
+    }
+
+    // read-only parent state (already restored from the trail)
+    ProjectData parent;
+    task.p->copy_to(parent);
+
+    // pump statuses of each child (x is restored for the current child afterwards)
+    const int y_current = task.y[h];
+    std::vector<std::vector<int>> x(num_children);
+    siblings[h].assign(num_children, BBSibling());
+    for (int k = 0; k < num_children; ++k)
+    {
+      task.y[h] = k;
+      updateX(task);
+      siblings[h][k].simulated = task.is_feasible;
+      if (task.is_feasible) x[k] = task.x;
+    }
+    task.y[h] = y_current;
+    updateX(task);
+    siblings_parent[h].assign(task.y.begin() + 1, task.y.begin() + h);
+
+#pragma omp critical(bb_mpi)
+    constraints.sync_best();
+    const double best = best_cost();
+
+#pragma omp parallel for num_threads(config.siblings) schedule(dynamic)
+    for (int k = 0; k < num_children; ++k)
+    {
+      if (!siblings[h][k].simulated) continue;
+      Project &q = *replicas[k];
+      q.copy_from(parent);
+      constraints.update_pumps(q, h, x[k], false);
+      simulateSibling(q, h, best, siblings[h][k]);
+    }
+  }
+
+  // Simulates hour h of one child, recording the checks of epanetSolve step by step
+  void simulateSibling(Project &q, int h, double best, BBSibling &child)
+  {
+    const int t_max = 3600 * h;
+    int t = 0, dt = 0, t_new;
+    do
+    {
+      CHK(q.runSolver(&t), "Run solver");
+      CHK(q.advanceSolver(&dt), "Advance solver");
+      t_new = t + dt;
+
+      BBSibling::Step step;
+      step.before_cost = !constraints.check_levels(q)    ? BBPrune::Reason::LEVELS
+                         : !constraints.check_timestep(dt) ? BBPrune::Reason::TIMESTEP
+                                                           : BBPrune::Reason::NONE;
+      step.cost = constraints.calc_cost(q);
+      step.bound = constraints.cost_bound(q);
+      step.after_cost = constraints.check_pressures(q) ? BBPrune::Reason::NONE : BBPrune::Reason::PRESSURES;
+      child.steps.push_back(step);
+
+      // the incumbent can only improve, so a child pruned now is pruned at its turn too
+      if (step.before_cost != BBPrune::Reason::NONE || !is_cheaper(step, best) || step.after_cost != BBPrune::Reason::NONE)
+        return;
+
+      if (t_new == t_max && h != config.h_max) break;
+    } while (dt > 0);
+
+    if (h == config.h_max) child.stability = constraints.check_stability(q);
+    q.copy_to(child.state);
+    child.completed = true;
+  }
+
+  // Outcome of epanetSolve for the current child, given the incumbent of this moment. A child of the
+  // memo was simulated with cleared energy accumulators: its costs add to cost, and its end state to
+  // the accumulators of start.
+  BBPrune::Reason replaySibling(BBTask &task, const BBSibling &child, double cost = 0.0, const ProjectData *start = nullptr)
+  {
+    const double best = budget(cost);
+    task.is_feasible = false;
+    for (const BBSibling::Step &step : child.steps)
+    {
+      if (step.before_cost != BBPrune::Reason::NONE) return step.before_cost;
+      task.cost = cost + step.cost;
+      if (!is_cheaper(step, best))
+      {
+        task.y[task.h] = task.num_pumps; // jump to end
+        return BBPrune::Reason::COST;
+      }
+      if (step.after_cost != BBPrune::Reason::NONE) return step.after_cost;
+    }
+    if (!child.completed) throw std::runtime_error("BBSolver::replaySibling: incomplete child");
+
+    task.is_feasible = true;
+    if (start)
+    {
+      memo_hour = child.state;
+      BBMemo::merge_energy(*task.p->getNetwork(), *start, memo_hour);
+      task.p->copy_from(memo_hour);
+    }
+    else
+      task.p->copy_from(child.state);
+    if (task.h == config.h_max)
+    {
+      if (child.stability != BBPrune::Reason::NONE) return child.stability;
+      constraints.update_best(task.cost, task.x, task.y);
+    }
+    return BBPrune::Reason::NONE;
+  }
+
+  //===============================================================
+  // 5c) Memo mode: replays the hour if its (reduced state, x[h]) was simulated before
+  //===============================================================
+  BBPrune::Reason memoSolve(BBTask &task)
+  {
+    Project &p = *(task.p);
+    const int *x = &task.x[task.h * task.num_pumps];
+    const double cost = constraints.calc_cost(p); // accumulated before the hour
+    p.copy_to(memo_state);
+    BBMemo::reduce(p, memo_key);
+    std::shared_ptr<const BBSibling> result = memo.find(memo_key, x);
+
+    // a record cut short by the incumbent of its own simulation may end too early for this one
+    if (result && !result->completed)
+    {
+      const BBSibling::Step &last = result->steps.back();
+      if (last.before_cost == BBPrune::Reason::NONE && last.after_cost == BBPrune::Reason::NONE && is_cheaper(last, budget(cost)))
+        result = nullptr;
+    }
+    stats.add_memo(result != nullptr, task.h);
+    if (!result)
+    {
+#pragma omp critical(bb_mpi)
+      constraints.sync_best();
+      auto child = std::make_shared<BBSibling>();
+      child->simulated = true;
+      BBMemo::split_energy(*p.getNetwork(), memo_state, memo_hour);
+      p.copy_from(memo_hour);
+      simulateSibling(p, task.h, budget(cost), *child);
+      memo.insert(memo_key, x, child, child->memory());
+      result = std::move(child);
+    }
+    return replaySibling(task, *result, cost, &memo_state);
+  }
+
+  // Incumbent less the cost already accumulated (the costs of the memo are those of the hour alone)
+  double budget(double cost) const
+  {
+    const double best = best_cost();
+    return (best < std::numeric_limits<double>::max()) ? best - cost : best;
+  }
+
+  // Cost check of check_cost (the bound only applies once there is an incumbent)
+  static bool is_cheaper(const BBSibling::Step &step, double best)
+  {
+    const double lb = (best < std::numeric_limits<double>::max()) ? step.bound : 0.0;
+    return step.cost + lb < best;
+  }
+
+  //===============================================================
+  // 6) Looks up the state at the end of hour task.h in the transposition table
+  //===============================================================
+  BBPrune::Reason checkDominance(BBTask &task)
+  {
+    if (!dominance.enabled() || warm_start || task.h >= config.h_max) return BBPrune::Reason::NONE;
+
+    std::vector<double> levels(constraints.get_num_tanks());
+    constraints.get_levels(*task.p, levels.data());
+
+    // remaining actuations, including the switches at the start of hour task.h
+    std::vector<int> allowed_01(task.num_pumps, config.max_actuations);
+    std::vector<int> allowed_10(task.num_pumps, config.max_actuations);
+    BBPumpController::computeAllowedSwitches(task.num_pumps, &task.x[0], task.h + 1, allowed_01, allowed_10);
+
+    BBDominance::Result result = dominance.check(task.h, levels.data(), &task.x[task.h * task.num_pumps], allowed_01.data(),
+                                                 allowed_10.data(), task.cost);
+    stats.add_lookup(result != BBDominance::MISS, task.h);
+    if (result != BBDominance::PRUNE) return BBPrune::Reason::NONE;
+
+    if (config.verbose)
+      Console::printf(Console::Color::RED, "TID[%d]: dominated state at h=%d, cost=%.2f\n", task.tid, task.h, task.cost);
+    task.is_feasible = false;
+    return BBPrune::Reason::DOMINANCE;
+  }
 };
 
-void processTask(BBTask &task, BBConfig &config, BBConstraints &constraints, BBStatistics &stats)
+void processTask(BBTask &task, BBConfig &config, BBConstraints &constraints, BBStatistics &stats, BBDominance &dominance,
+                 BBPrefixTrie &prefixes, BBMemo &memo)
 {
-  ProfileScope scope("processTask");
-  BBSolver solver(config, constraints, stats);
+  PROFILE_TRACE_SCOPE("processTask");
+  PROFILE_ANNOTATE("task", task.uid);
+  BBSolver solver(config, constraints, stats, dominance, prefixes, memo);
   solver.solveTask(task);
 }
@@ -5,6 +5,7 @@
 #include "CLI/BBConstraints.h"
 
 #include <fstream>
+#include <limits>
 #include <mpi.h>
 #include <nlohmann/json.hpp>
 #include <string>
@@ -14,7 +15,14 @@ class BBStatistics
 public:
   std::map<BBPrune::Reason, std::vector<int>> data;
   std::map<BBPrune::Reason, std::string> labels;
+  std::vector<int> tt_hits;   ///< Transposition table lookups that found the key (per hour)
+  std::vector<int> tt_misses; ///< Transposition table lookups that stored a new key (per hour)
+  std::vector<int> memo_hits;   ///< Hours replayed from the simulation memo (per hour)
+  std::vector<int> memo_misses; ///< Hours simulated and stored in the simulation memo (per hour)
   double duration;
+  double heuristic_duration = 0.0; ///< Time spent in the warm-start heuristic (seconds)
+  double heuristic_budget = 0.0;   ///< Time budget of the warm-start heuristic (seconds)
+  double heuristic_cost = std::numeric_limits<double>::max(); ///< Cost of the warm-start incumbent
 
   BBStatistics(const BBConfig &config)
   {
@@ -25,6 +33,10 @@ public:
     {
       data[reason] = std::vector<int>(config.h_max + 1, 0);
     }
+    tt_hits.assign(config.h_max + 1, 0);
+    tt_misses.assign(config.h_max + 1, 0);
+    memo_hits.assign(config.h_max + 1, 0);
+    memo_misses.assign(config.h_max + 1, 0);
   }
   ~BBStatistics()
   {
@@ -35,6 +47,16 @@ public:
     data[reason][h]++;
   }
 
+  inline void add_lookup(bool hit, int h)
+  {
+    (hit ? tt_hits : tt_misses)[h]++;
+  }
+
+  inline void add_memo(bool hit, int h)
+  {
+    (hit ? memo_hits : memo_misses)[h]++;
+  }
+
   void to_json(char *fn) const
   {
     int rank;
@@ -49,7 +71,14 @@ public:
     {
       j[labels.at(reason)] = counts;
     }
+    j["TT_HITS"] = tt_hits;
+    j["TT_MISSES"] = tt_misses;
+    j["MEMO_HITS"] = memo_hits;
+    j["MEMO_MISSES"] = memo_misses;
     j["duration"] = duration;
+    j["heuristic"] = {{"duration", heuristic_duration},
+                      {"budget", heuristic_budget},
+                      {"cost", heuristic_cost < std::numeric_limits<double>::max() ? nlohmann::json(heuristic_cost) : nlohmann::json()}};
     std::ofstream f(fn);
     f << j.dump(2);
   }
@@ -64,6 +93,16 @@ public:
         data[reason][h] += counts[h];
       }
     }
+    for (int h = 0; h < other.tt_hits.size(); ++h)
+    {
+      tt_hits[h] += other.tt_hits[h];
+      tt_misses[h] += other.tt_misses[h];
+    }
+    for (int h = 0; h < other.memo_hits.size(); ++h)
+    {
+      memo_hits[h] += other.memo_hits[h];
+      memo_misses[h] += other.memo_misses[h];
+    }
   }
 
   void show() const
@@ -74,6 +113,7 @@ public:
     Console::hline(Console::Color::BRIGHT_YELLOW, 20);
     Console::printf(Console::Color::BRIGHT_YELLOW, "TID[%d]: Statistics\n", rank);
     Console::printf(Console::Color::BRIGHT_YELLOW, "Duration: %.3f seconds\n", duration);
+    Console::printf(Console::Color::BRIGHT_YELLOW, "Heuristic: %.3f seconds, cost=%.2f\n", heuristic_duration, heuristic_cost);
     for (const auto &[type, counts] : data)
     {
       Console::printf(Console::Color::CYAN, "%10s: [", labels.at(type).c_str());
@@ -83,5 +123,15 @@ public:
       }
       Console::printf(Console::Color::CYAN, "]\n");
     }
+    for (const auto &[label, counts] : {std::make_pair("TT_HITS", &tt_hits), std::make_pair("TT_MISSES", &tt_misses),
+                                   std::make_pair("MEMO_HITS", &memo_hits), std::make_pair("MEMO_MISSES", &memo_misses)})
+    {
+      Console::printf(Console::Color::CYAN, "%10s: [", label);
+      for (int i = 0; i < counts->size(); ++i)
+      {
+        Console::printf(Console::Color::CYAN, "%d, ", (*counts)[i]);
+      }
+      Console::printf(Console::Color::CYAN, "]\n");
+    }
   }
 };
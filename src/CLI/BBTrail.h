@@ -0,0 +1,143 @@
+// src/CLI/BBTrail.h
+#pragma once
+
+#include "Core/project.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Epanet::Project;
+
+/**
+ * @brief Undo log (trail) of the simulation states along the current branch of a task
+ *
+ * Only the state of the deepest saved level is kept in full (a flat ProjectData). Saving the state
+ * of level h records the old values of the runs of 8-byte words that changed since level h - 1, and
+ * backtracking replays these runs in reverse order. The matrix solver's coefficients are left out
+ * of the log: every solve rewrites them before reading them. A level then costs 8 bytes per changed
+ * word plus 8 bytes per run instead of a full snapshot.
+ */
+class BBTrail
+{
+public:
+  /**
+   * @brief Clears the trail and takes the current state of the project as the state of level h
+   */
+  void init(Project &p, int h)
+  {
+    p.copy_to(top);
+    runs.clear();
+    values.clear();
+    marks.clear();
+    h_base = h_top = h;
+  }
+
+  /**
+   * @brief Releases the memory of the trail (e.g. once its task is done)
+   */
+  void clear()
+  {
+    top = ProjectData();
+    runs = std::vector<Run>();
+    values = std::vector<uint64_t>();
+    marks = std::vector<size_t>();
+    h_base = h_top = 0;
+  }
+
+  /**
+   * @brief Backtracks to level h (unwinding the deeper levels) and loads its state into the project
+   */
+  void restore(Project &p, int h)
+  {
+    if (h < h_base || h > h_top)
+      throw std::runtime_error("BBTrail::restore: level " + std::to_string(h) + " not in [" + std::to_string(h_base) + ", " +
+                               std::to_string(h_top) + "]");
+    while (h_top > h) unwind();
+    p.copy_from(top);
+  }
+
+  /**
+   * @brief Records the current state of the project as the state of level h (one level below the top)
+   */
+  void save(Project &p, int h)
+  {
+    if (h != h_top + 1)
+      throw std::runtime_error("BBTrail::save: level " + std::to_string(h) + " is not below level " + std::to_string(h_top));
+
+    // scratch copy of the new state, shared by the trails of the tasks a thread runs
+    static thread_local ProjectData work;
+    p.copy_to(work);
+
+    // the snapshot sections are padded to 8 bytes, so the logged state is a whole number of words
+    const uint32_t num_words = static_cast<uint32_t>(top.matrixSolver / sizeof(uint64_t));
+    uint64_t *old_words = reinterpret_cast<uint64_t *>(top.data());
+    const uint64_t *new_words = reinterpret_cast<const uint64_t *>(work.data());
+
+    marks.push_back(runs.size());
+    for (uint32_t i = 0; i < num_words;)
+    {
+      if (old_words[i] == new_words[i])
+      {
+        ++i;
+        continue;
+      }
+      Run run{i, 0};
+      for (; i < num_words && old_words[i] != new_words[i]; ++i, ++run.count)
+      {
+        values.push_back(old_words[i]);
+        old_words[i] = new_words[i];
+      }
+      runs.push_back(run);
+    }
+    h_top = h;
+  }
+
+  /**
+   * @brief Deepest level whose state is stored
+   */
+  int level() const
+  {
+    return h_top;
+  }
+
+  /**
+   * @brief Memory held by the trail (bytes), full state of the top level included
+   */
+  size_t memory() const
+  {
+    return top.size() + runs.capacity() * sizeof(Run) + values.capacity() * sizeof(uint64_t) + marks.capacity() * sizeof(size_t);
+  }
+
+private:
+  struct Run
+  {
+    uint32_t word;  ///< index of the first changed 8-byte word in the flat state
+    uint32_t count; ///< number of consecutive changed words (old values at the end of values)
+  };
+
+  void unwind()
+  {
+    uint64_t *words = reinterpret_cast<uint64_t *>(top.data());
+    size_t v = values.size();
+    for (size_t k = runs.size(); k > marks.back(); --k)
+    {
+      const Run &run = runs[k - 1];
+      v -= run.count;
+      std::memcpy(words + run.word, values.data() + v, run.count * sizeof(uint64_t));
+    }
+    runs.resize(marks.back());
+    values.resize(v);
+    marks.pop_back();
+    --h_top;
+  }
+
+  ProjectData top;              ///< state of level h_top (matrix solver coeffs. as given to init)
+  std::vector<Run> runs;        ///< runs of changed words of the levels h_base + 1 .. h_top
+  std::vector<uint64_t> values; ///< values of the changed words in the parent level
+  std::vector<size_t> marks;    ///< first run of each level
+  int h_base = 0;               ///< level given to init (cannot be unwound)
+  int h_top = 0;
+};
@@ -123,7 +123,7 @@ void CHK(int err, const std::string &message)
 void show_timer(int mpi_rank, unsigned int niter, int h, int done_loc, int done_all, double cost, std::vector<int> &y, std::vector<int> &y_best,
                 int is_feasible, std::chrono::high_resolution_clock::time_point tic)
 {
-  ProfileScope scope("show_timer");
+  PROFILE_SCOPE("show_timer");
 
   // Only show the timer every `interval` iterations
   if (mpi_rank == 0)
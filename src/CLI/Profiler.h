@@ -4,44 +4,161 @@
 #include "Console.h"
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <fstream>
 #include <iomanip>
+#include <map>
+#include <memory>
 #include <mpi.h>
-#include <stack>
+#include <mutex>
+#include <sstream>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+/**
+ * @brief Hierarchical profiler of the scopes marked with PROFILE_SCOPE
+ *
+ * Each call site interns its name once, so entering a scope only reads the clock and looks up the
+ * scope among the children of the current node of the call tree. Every thread owns a fixed-size
+ * call tree and stack, registered on its first scope, so the hot path takes no lock and allocates
+ * nothing. Profiler::save merges the trees of the threads and writes the calls, inclusive and
+ * exclusive times of each call path, for the process and (on rank 0) for all processes.
+ *
+ * With Profiler::startTrace, the scopes marked with PROFILE_TRACE_SCOPE (tasks, levels, solver
+ * calls and MPI waits, not the finer scopes they contain) and every PROFILE_EVENT are also recorded
+ * as timeline events (up to a fixed number per thread). Profiler::saveTrace gathers the events of all processes in one
+ * Chrome trace JSON file (chrome://tracing, ui.perfetto.dev): one process per rank, one track per thread.
+ *
+ * Building without BB_PROFILE (make PROFILE=0) compiles PROFILE_SCOPE, PROFILE_TRACE_SCOPE,
+ * PROFILE_EVENT and PROFILE_ANNOTATE to nothing.
+ */
 class Profiler
 {
 public:
-  static void push(const std::string &name)
+  static constexpr int MAX_NODES = 1024; ///< call-tree nodes per thread (new call paths beyond are not recorded)
+  static constexpr int MAX_DEPTH = 64;   ///< recorded nesting depth per thread
+
+  struct Totals
+  {
+    int64_t calls = 0;
+    int64_t inclusive = 0; ///< ns
+  };
+
+  /**
+   * @brief Returns the id of a scope name (called once per call site by PROFILE_SCOPE)
+   */
+  static int intern(const char *name)
   {
-    // Create a new stack frame with current time
-    callStack.push({name, std::chrono::high_resolution_clock::now()});
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = std::find(names.begin(), names.end(), name);
+    if (it != names.end()) return int(it - names.begin());
+    names.push_back(name);
+    return int(names.size()) - 1;
+  }
+
+  static void push(int id, bool trace)
+  {
+    ThreadProfile &tp = local();
+    if (tp.depth++ >= MAX_DEPTH) return;
+    Frame &frame = tp.stack[tp.depth - 1];
+    frame.id = id;
+    frame.trace = trace && tracing;
+    frame.arg = -1;
+    frame.parent = tp.current;
+    frame.node = (tp.current >= 0) ? tp.child(tp.current, id) : -1;
+    tp.current = frame.node;
+    if (frame.node >= 0 || frame.trace) frame.start = now();
   }
 
   static void pop()
   {
-    auto [name, start_time] = callStack.top();
-    auto end_time = std::chrono::high_resolution_clock::now();
+    ThreadProfile &tp = local();
+    if (--tp.depth >= MAX_DEPTH) return;
+    const Frame &frame = tp.stack[tp.depth];
+    if (frame.node >= 0 || frame.trace)
+    {
+      const int64_t duration = now() - frame.start;
+      if (frame.node >= 0)
+      {
+        Node &node = tp.nodes[frame.node];
+        ++node.calls;
+        node.ticks += duration;
+      }
+      if (frame.trace) tp.record({frame.id, frame.arg, frame.value, frame.start, duration});
+    }
+    tp.current = frame.parent;
+  }
 
-    // Add the duration to the profile
-    profile[name] += std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
+  /**
+   * @brief Attaches a named value (e.g., the task id) to the trace event of the innermost open scope (if traced)
+   */
+  static void annotate(int arg, double value)
+  {
+    ThreadProfile &tp = local();
+    if (tp.depth == 0 || tp.depth > MAX_DEPTH) return;
+    tp.stack[tp.depth - 1].arg = arg;
+    tp.stack[tp.depth - 1].value = value;
+  }
 
-    callStack.pop();
+  /**
+   * @brief Records an instant trace event with a named value (e.g., an incumbent update)
+   */
+  static void event(int id, int arg, double value)
+  {
+    if (tracing) local().record({id, arg, value, now(), -1});
+  }
+
+  /**
+   * @brief Starts recording trace events (collective: the ranks agree on the time origin)
+   * @param max_events Events kept per thread (later ones are dropped)
+   */
+  static void startTrace(size_t max_events)
+  {
+    MPI_Barrier(MPI_COMM_WORLD);
+    traceOrigin = now();
+    traceCapacity = max_events;
+    tracing = true;
   }
 
-  static const std::unordered_map<std::string, std::chrono::microseconds> &getProfile()
+  /**
+   * @brief Call counts and inclusive times (ns) of this process, keyed by call path ("main/processTask/...")
+   *
+   * Threads are summed. Scopes still open (e.g., main) count as one call lasting until now.
+   */
+  static std::map<std::string, Totals> getProfile()
   {
-    return profile;
+    std::map<std::string, Totals> merged;
+    const int64_t t = now();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const auto &tp : registry)
+    {
+      std::vector<Totals> totals(tp->num_nodes);
+      for (int i = 1; i < tp->num_nodes; ++i) totals[i] = {tp->nodes[i].calls, tp->nodes[i].ticks};
+      for (int d = 0; d < std::min(tp->depth, MAX_DEPTH); ++d)
+      {
+        const Frame &frame = tp->stack[d];
+        if (frame.node < 0) continue;
+        ++totals[frame.node].calls;
+        totals[frame.node].inclusive += t - frame.start;
+      }
+      for (int i = 1; i < tp->num_nodes; ++i)
+      {
+        if (totals[i].calls == 0) continue;
+        Totals &entry = merged[tp->path(i)];
+        entry.calls += totals[i].calls;
+        entry.inclusive += totals[i].inclusive;
+      }
+    }
+    return merged;
   }
 
   static void save(const std::string &fn)
   {
+#ifdef BB_PROFILE
     // Get MPI rank
-    int rank;
+    int rank, num_procs;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
 
     // Only rank 0 prints the summary message
     if (rank == 0)
@@ -49,43 +166,246 @@ public:
       Console::printf(Console::Color::BRIGHT_GREEN, "💾 Writing profile to file: %s\n", fn.c_str());
     }
 
+    const auto profile = getProfile();
+
+    // Gather the profiles of all processes on rank 0 (one "path calls inclusive" line per call path)
+    std::ostringstream lines;
+    for (const auto &[path, totals] : profile) lines << path << ' ' << totals.calls << ' ' << totals.inclusive << '\n';
+    const std::string texts = gather(lines.str());
+
     std::ofstream outfile(fn);
+    write(outfile, "Rank " + std::to_string(rank), profile);
+    if (rank == 0 && num_procs > 1)
+    {
+      std::map<std::string, Totals> merged;
+      std::istringstream all(texts);
+      std::string path;
+      Totals totals;
+      while (all >> path >> totals.calls >> totals.inclusive)
+      {
+        merged[path].calls += totals.calls;
+        merged[path].inclusive += totals.inclusive;
+      }
+      write(outfile, "All ranks", merged);
+    }
+    outfile.close();
+#else
+    (void)fn;
+#endif
+  }
 
-    outfile << "=== Profiling Results (Rank " << rank << ") ===\n";
+  /**
+   * @brief Writes the trace events of all processes to one Chrome trace JSON file (collective, rank 0 writes)
+   */
+  static void saveTrace(const std::string &fn)
+  {
+#ifdef BB_PROFILE
+    if (!tracing) return;
+    tracing = false;
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
-    // Create vector of pairs to sort
-    std::vector<std::pair<std::string, std::chrono::microseconds>> sorted_profile(profile.begin(), profile.end());
+    // Complete ("X") and instant ("i") events, timestamps in microseconds since startTrace
+    std::ostringstream events;
+    events << std::fixed << std::setprecision(3);
+    size_t dropped = 0;
+    {
+      std::lock_guard<std::mutex> lock(registryMutex);
+      events << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"args\":{\"name\":\"rank " << rank << "\"}},\n";
+      for (size_t tid = 0; tid < registry.size(); ++tid)
+      {
+        const ThreadProfile &tp = *registry[tid];
+        dropped += tp.dropped;
+        events << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << rank << ",\"tid\":" << tid
+               << ",\"args\":{\"name\":\"thread " << tid << "\"}},\n";
+        for (const Event &e : tp.events)
+        {
+          events << "{\"name\":\"" << names[e.id] << "\",\"pid\":" << rank << ",\"tid\":" << tid << ",\"ts\":" << (e.start - traceOrigin) / 1e3;
+          if (e.duration >= 0)
+            events << ",\"ph\":\"X\",\"dur\":" << e.duration / 1e3;
+          else
+            events << ",\"ph\":\"i\",\"s\":\"t\"";
+          if (e.arg >= 0) events << ",\"args\":{\"" << names[e.arg] << "\":" << std::setprecision(6) << e.value << std::setprecision(3) << "}";
+          events << "},\n";
+        }
+      }
+    }
+    if (dropped > 0)
+      Console::printf(Console::Color::BRIGHT_RED, "Warning: rank %d dropped %zu trace events (trace buffers full)\n", rank, dropped);
 
-    // Sort by duration in descending order
-    std::sort(sorted_profile.begin(), sorted_profile.end(), [](const auto &a, const auto &b) { return a.second > b.second; });
+    const std::string all = gather(events.str());
+    if (rank == 0)
+    {
+      Console::printf(Console::Color::BRIGHT_GREEN, "💾 Writing trace to file: %s\n", fn.c_str());
+      std::ofstream outfile(fn);
+      // drop the separator after the last event
+      outfile << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" << all.substr(0, all.size() - 2) << "\n]}\n";
+    }
+#else
+    (void)fn;
+#endif
+  }
+
+private:
+  struct Node
+  {
+    int id = -1;           ///< interned name (-1: root)
+    int parent = -1;
+    int first_child = -1;
+    int next_sibling = -1;
+    int64_t calls = 0;
+    int64_t ticks = 0;     ///< inclusive time (ns)
+  };
 
-    // Get the maximum duration for calculating percentages
-    auto max_duration = sorted_profile.front().second.count();
+  struct Frame
+  {
+    int id;       ///< interned name
+    bool trace;   ///< recorded as a trace event
+    int node;     ///< call-tree node (-1: not recorded)
+    int parent;   ///< node to return to
+    int arg;      ///< interned name of the annotation (-1: none)
+    double value; ///< annotation
+    int64_t start;
+  };
 
-    // Set output format
-    outfile << std::fixed << std::setprecision(2);
+  struct Event
+  {
+    int id;           ///< interned name
+    int arg;          ///< interned name of the value (-1: none)
+    double value;
+    int64_t start;    ///< ns
+    int64_t duration; ///< ns (-1: instant event)
+  };
+
+  // Each thread owns its call tree and stack, merged only when the profile is read
+  struct ThreadProfile
+  {
+    Node nodes[MAX_NODES]; ///< nodes[0] is the root
+    int num_nodes = 1;
+    Frame stack[MAX_DEPTH];
+    int depth = 0;
+    int current = 0;
+    std::vector<Event> events; ///< trace events (startTrace)
+    size_t dropped = 0;        ///< trace events beyond traceCapacity
 
-    for (const auto &[name, duration] : sorted_profile)
+    void record(const Event &event)
     {
-      double ms = duration.count() / 1000.0;
-      double percentage = (duration.count() * 100.0) / max_duration;
+      if (events.size() < traceCapacity)
+        events.push_back(event);
+      else
+        ++dropped;
+    }
 
-      outfile << std::left << std::setw(30) << name << ": " << std::right << std::setw(8) << ms << " ms" << " (" << std::setw(5) << percentage
-              << "%)\n";
+    // Returns the child of parent for the scope id, creating it if there is room (-1 otherwise)
+    int child(int parent, int id)
+    {
+      int last = -1;
+      for (int i = nodes[parent].first_child; i >= 0; i = nodes[i].next_sibling)
+      {
+        if (nodes[i].id == id) return i;
+        last = i;
+      }
+      if (num_nodes == MAX_NODES) return -1;
+      const int i = num_nodes++;
+      nodes[i].id = id;
+      nodes[i].parent = parent;
+      (last < 0 ? nodes[parent].first_child : nodes[last].next_sibling) = i;
+      return i;
     }
-    outfile << "=====================\n";
-    outfile.close();
+
+    // Call path of a node (registry lock held)
+    std::string path(int i) const
+    {
+      std::string p = names[nodes[i].id];
+      for (i = nodes[i].parent; i > 0; i = nodes[i].parent) p = names[nodes[i].id] + "/" + p;
+      return p;
+    }
+  };
+
+  static int64_t now()
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
   }
 
-private:
-  struct StackFrame
+  static ThreadProfile &local()
   {
-    std::string name;
-    std::chrono::high_resolution_clock::time_point start_time;
-  };
+    thread_local ThreadProfile *tp = nullptr;
+    if (!tp)
+    {
+      std::lock_guard<std::mutex> lock(registryMutex);
+      registry.push_back(std::make_unique<ThreadProfile>());
+      tp = registry.back().get();
+    }
+    return *tp;
+  }
+
+  // Concatenates the texts of all processes on rank 0 (empty on the other ranks)
+  static std::string gather(const std::string &text)
+  {
+    int rank, num_procs;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
+    int size = (int)text.size();
+    std::vector<int> sizes(num_procs), offsets(num_procs, 0);
+    MPI_Gather(&size, 1, MPI_INT, sizes.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    for (int i = 1; i < num_procs; ++i) offsets[i] = offsets[i - 1] + sizes[i - 1];
+    std::vector<char> texts(rank == 0 ? offsets.back() + sizes.back() : 0);
+    MPI_Gatherv(text.data(), size, MPI_CHAR, texts.data(), sizes.data(), offsets.data(), MPI_CHAR, 0, MPI_COMM_WORLD);
+    return std::string(texts.begin(), texts.end());
+  }
+
+  // Writes the call tree, children sorted by decreasing inclusive time
+  static void write(std::ofstream &outfile, const std::string &title, const std::map<std::string, Totals> &profile)
+  {
+    outfile << "=== Profiling Results (" << title << ") ===\n";
+    outfile << std::right << std::setw(10) << "calls" << std::setw(14) << "incl. ms" << std::setw(14) << "excl. ms" << std::setw(9) << "%"
+            << "  scope\n";
+    if (profile.empty())
+    {
+      outfile << "=====================\n";
+      return;
+    }
 
-  static inline std::stack<StackFrame> callStack;
-  static inline std::unordered_map<std::string, std::chrono::microseconds> profile;
+    // children of each path ("" for the roots)
+    std::map<std::string, std::vector<std::string>> children;
+    for (const auto &[path, totals] : profile)
+    {
+      const size_t slash = path.find_last_of('/');
+      children[slash == std::string::npos ? "" : path.substr(0, slash)].push_back(path);
+    }
+    for (auto &[parent, paths] : children)
+      std::sort(paths.begin(), paths.end(),
+                [&profile](const std::string &a, const std::string &b) { return profile.at(a).inclusive > profile.at(b).inclusive; });
+
+    int64_t total = 0;
+    for (const std::string &root : children[""]) total = std::max(total, profile.at(root).inclusive);
+
+    outfile << std::fixed << std::setprecision(2);
+    auto visit = [&](const auto &self, const std::string &path, int depth) -> void
+    {
+      const Totals &totals = profile.at(path);
+      int64_t exclusive = totals.inclusive;
+      auto it = children.find(path);
+      if (it != children.end())
+        for (const std::string &child : it->second) exclusive -= profile.at(child).inclusive;
+
+      const size_t slash = path.find_last_of('/');
+      outfile << std::setw(10) << totals.calls << std::setw(14) << totals.inclusive / 1e6 << std::setw(14) << exclusive / 1e6
+              << std::setw(9) << (total > 0 ? totals.inclusive * 100.0 / total : 0.0) << "  " << std::string(2 * depth, ' ')
+              << (slash == std::string::npos ? path : path.substr(slash + 1)) << '\n';
+      if (it != children.end())
+        for (const std::string &child : it->second) self(self, child, depth + 1);
+    };
+    for (const std::string &root : children[""]) visit(visit, root, 0);
+    outfile << "=====================\n";
+  }
+
+  static inline std::mutex registryMutex;
+  static inline std::vector<std::unique_ptr<ThreadProfile>> registry;
+  static inline std::vector<std::string> names; ///< scope names by id
+  static inline bool tracing = false;           ///< record trace events (set before the worker threads start)
+  static inline size_t traceCapacity = 0;       ///< trace events kept per thread
+  static inline int64_t traceOrigin = 0;        ///< time origin of the trace (ns)
 
   // Prevent instantiation
   Profiler() = delete;
@@ -96,9 +416,9 @@ private:
 class ProfileScope
 {
 public:
-  explicit ProfileScope(const std::string &name) : name_(name)
+  explicit ProfileScope(int id, bool trace = false)
   {
-    Profiler::push(name_);
+    Profiler::push(id, trace);
   }
 
   ~ProfileScope()
@@ -107,9 +427,44 @@ public:
   }
 
 private:
-  std::string name_;
-
   // Prevent copying and assignment
   ProfileScope(const ProfileScope &) = delete;
   ProfileScope &operator=(const ProfileScope &) = delete;
 };
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Profiles the enclosing block under the given name (a string literal)
+#ifdef BB_PROFILE
+#define PROFILE_SCOPE(name)                                                                                                            \
+  static const int PROFILE_CONCAT(profile_id_, __LINE__) = Profiler::intern(name);                                                    \
+  ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(PROFILE_CONCAT(profile_id_, __LINE__))
+
+// Profiles the enclosing block like PROFILE_SCOPE and also records it in the trace (coarse scopes only)
+#define PROFILE_TRACE_SCOPE(name)                                                                                                      \
+  static const int PROFILE_CONCAT(profile_id_, __LINE__) = Profiler::intern(name);                                                    \
+  ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(PROFILE_CONCAT(profile_id_, __LINE__), true)
+
+// Names the value of the trace event of the enclosing PROFILE_SCOPE (e.g., PROFILE_ANNOTATE("task", uid))
+#define PROFILE_ANNOTATE(arg, value)                                                                                                   \
+  do                                                                                                                                   \
+  {                                                                                                                                    \
+    static const int profile_arg = Profiler::intern(arg);                                                                            \
+    Profiler::annotate(profile_arg, value);                                                                                            \
+  } while (0)
+
+// Records an instant trace event with a named value (e.g., PROFILE_EVENT("incumbent", "cost", cost))
+#define PROFILE_EVENT(name, arg, value)                                                                                                \
+  do                                                                                                                                   \
+  {                                                                                                                                    \
+    static const int profile_id = Profiler::intern(name);                                                                            \
+    static const int profile_arg = Profiler::intern(arg);                                                                            \
+    Profiler::event(profile_id, profile_arg, value);                                                                                   \
+  } while (0)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_TRACE_SCOPE(name) ((void)0)
+#define PROFILE_ANNOTATE(arg, value) ((void)0)
+#define PROFILE_EVENT(name, arg, value) ((void)0)
+#endif
@@ -1,12 +1,14 @@
 // src/CLI/main.cpp
 
 #include "BBConfig.h"
+#include "BBScheduler.h"
 #include "BBSolver.h"
 #include "BBStatistics.h"
 #include "Profiler.h"
 
 #include <algorithm>
 #include <mpi.h>
+#include <omp.h>
 #include <random>
 #include <string>
 #include <vector>
@@ -53,7 +55,7 @@ void populate_tasks(std::vector<BBTask> &tasks, const BBConfig &config, const BB
 
   for (size_t uid = 0; uid < tasks.size(); uid++)
   {
-    // set the uid
+    // set the uid (and the owner used by the static schedule)
     tasks[uid].uid = uid;
     tasks[uid].tid = uid % num_procs;
   }
@@ -68,50 +70,100 @@ void populate_tasks(std::vector<BBTask> &tasks, const BBConfig &config, const BB
 
 int main(int argc, char *argv[])
 {
-  MPI_Init(&argc, &argv);
+  // Worker threads take turns calling MPI (scheduler and incumbent sharing)
+  int thread_support;
+  MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &thread_support);
   int rank, num_procs;
   MPI_Comm_rank(MPI_COMM_WORLD, &rank);
   MPI_Comm_size(MPI_COMM_WORLD, &num_procs);
 
-  ProfileScope scope("main");
+  PROFILE_SCOPE("main");
 
   // Parse config
   BBConfig config(argc, argv);
   BBConstraints constraints(config);
   BBStatistics stats(config);
+  BBDominance dominance(config, constraints.get_num_tanks(), constraints.get_num_pumps());
+  BBPrefixTrie prefixes(config, constraints.get_num_pumps());
+  BBMemo memo(config, constraints.get_num_pumps());
+
+  if (thread_support < MPI_THREAD_SERIALIZED && config.num_threads > 1)
+  {
+    if (rank == 0) Console::printf(Console::Color::BRIGHT_RED, "Warning: MPI without MPI_THREAD_SERIALIZED support, using 1 thread\n");
+    config.num_threads = 1;
+  }
 
   if (rank == 0) config.show();
+  if (config.trace) Profiler::startTrace(config.trace_events);
+
+  // The sibling mode opens a parallel region inside each worker thread
+  if (config.siblings > 1) omp_set_max_active_levels(2);
 
   // Convert queue to vector for parallel processing
   std::vector<BBTask> tasks;
   populate_tasks(tasks, config, constraints);
 
+  BBScheduler scheduler(config, (int)tasks.size());
+
   auto tic = std::chrono::high_resolution_clock::now();
 
-  for (size_t i = 0; i < tasks.size(); i++)
+  // Warm start: only rank 0 runs the heuristic (the same dive on every rank would be redundant); each
+  // incumbent it finds goes through update_best/publish_best, and the other ranks, which start on the
+  // tasks right away, pick it up with sync_best
+  stats.heuristic_budget = (rank == 0) ? config.heuristic_s : 0.0;
+  if (config.heuristic_s > 0 && rank == 0)
   {
-    // Sync best before processing each task
-    constraints.sync_best();
+    BBStatistics heuristic_stats(config);
+    BBSolver heuristic(config, constraints, heuristic_stats, dominance, prefixes, memo);
+    if (heuristic.solveHeuristic(config.heuristic_s)) stats.heuristic_cost = constraints.best_cost_local;
+    auto toc = std::chrono::high_resolution_clock::now();
+    stats.heuristic_duration = std::chrono::duration_cast<std::chrono::microseconds>(toc - tic).count() / 1e6;
+    Console::printf(Console::Color::BRIGHT_YELLOW, "Heuristic: cost=%s in %.3f seconds\n", constraints.fmt_cost(stats.heuristic_cost).c_str(),
+                    stats.heuristic_duration);
+  }
 
-    // Skip tasks that are not assigned to this process
-    if (tasks[i].tid != rank) continue;
+  // Each worker thread owns its Project/BBSolver (created per task) and statistics, and pulls tasks from the scheduler
+#pragma omp parallel num_threads(config.num_threads)
+  {
+    BBStatistics thread_stats(config);
+    while (true)
+    {
+      int i;
+#pragma omp critical(bb_mpi)
+      {
+        i = scheduler.next();
+        // Sync best before processing each task
+        if (i >= 0) constraints.sync_best();
+      }
+      if (i < 0) break;
+
+      // Process the task
+      tasks[i].tid = rank;
+      processTask(tasks[i], config, constraints, thread_stats, dominance, prefixes, memo);
+    }
 
-    // Process the task
-    processTask(tasks[i], config, constraints, stats);
+#pragma omp critical(bb_stats)
+    stats.merge(thread_stats);
   }
 
   auto toc = std::chrono::high_resolution_clock::now();
   auto duration = std::chrono::duration_cast<std::chrono::microseconds>(toc - tic);
   stats.duration = duration.count() / 1e6; // seconds
 
-  Console::printf(Console::Color::BRIGHT_YELLOW, "Proc %02d finished in %.3f seconds, cost(local=%s, global=%s)\n", rank, stats.duration,
-                  constraints.fmt_cost(constraints.best_cost_local).c_str(), constraints.fmt_cost(constraints.best_cost_global).c_str());
+  // Termination: every process has run out of tasks
+  constraints.finish_sync();
+  scheduler.finalize();
+
+  Console::printf(Console::Color::BRIGHT_YELLOW, "Proc %02d finished %d tasks in %.3f seconds, cost(local=%s, global=%s)\n", rank,
+                  scheduler.get_num_fetched(), stats.duration, constraints.fmt_cost(constraints.best_cost_local).c_str(),
+                  constraints.fmt_cost(constraints.best_cost_global).c_str());
   fflush(stdout);
   MPI_Barrier(MPI_COMM_WORLD);
 
   stats.to_json(config.fn_stats);
   constraints.to_json(config.fn_best);
   Profiler::save(config.fn_profile);
+  Profiler::saveTrace(config.fn_trace);
 
   MPI_Finalize();
   return EXIT_SUCCESS;
@@ -152,31 +152,19 @@ int EN_clearProject(EN_Project p) {
 
 //-----------------------------------------------------------------------------
 
-////////////////////////////////////////////////////////////////
-//  NOT SURE IF THIS METHOD WORKS CORRECTLY -- NEEDS TESTING  //
-////////////////////////////////////////////////////////////////
 int EN_cloneProject(EN_Project pClone, EN_Project pSource) {
   if (pSource == nullptr || pClone == nullptr)
     return 102;
   int err = 0;
-  std::string tmpFile;
-  if (Utilities::getTmpFileName(tmpFile)) {
-    try {
-      EN_saveProject(tmpFile.c_str(), pSource);
-      EN_loadProject(tmpFile.c_str(), pClone);
-    } catch (ENerror const &e) {
-      project(pSource)->writeMsg(e.msg);
-      err = e.code;
-    } catch (...) {
-      err = 208; // Unspecified error
-    }
-    if (err > 0) {
-      EN_clearProject(pClone);
-    }
-    remove(tmpFile.c_str());
-    return err;
+  try {
+    err = project(pClone)->clone(project(pSource));
+  } catch (...) {
+    err = 208; // Unspecified error
+  }
+  if (err > 0) {
+    EN_clearProject(pClone);
   }
-  return 208;
+  return err;
 }
 
 //-----------------------------------------------------------------------------
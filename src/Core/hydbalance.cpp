@@ -15,27 +15,34 @@
 #include "hydbalance.h"
 #include "Elements/link.h"
 #include "Elements/node.h"
+#include "Models/headlossmodel.h"
 #include "network.h"
+#include "Solvers/hydstate.h"
 
 #include <cmath>
 #include <cstring>
 using namespace std;
 
-void findNodeOutflows(double lamda, double dH[], double xQ[], Network *nw);
-void findLeakageFlows(double lamda, double dH[], double xQ[], Network *nw);
-double findTotalFlowChange(double lamda, double dQ[], Network *nw);
+void findNodeOutflows(double lamda, double dH[], double xQ[], HydState &hs,
+                      Network *nw);
+void findLeakageFlows(double lamda, double dH[], double xQ[], HydState &hs,
+                      Network *nw);
+double findTotalFlowChange(double lamda, double dQ[], HydState &hs);
 
 //-----------------------------------------------------------------------------
 
 //  Evaluate the error in satisfying the conservation of flow and energy
 //  equations by an updated set of network heads and flows.
+//  (Heads and flows are read from hs, which also receives the new head
+//   losses, gradients and node outflows.)
 //
 
-double HydBalance::evaluate(double lamda, // step size
-                            double dH[],  // change in nodal heads
-                            double dQ[],  // change in link flows
-                            double xQ[],  // nodal inflow minus outflow
-                            Network *nw)  // network being analyzed
+double HydBalance::evaluate(double lamda,  // step size
+                            double dH[],   // change in nodal heads
+                            double dQ[],   // change in link flows
+                            double xQ[],   // nodal inflow minus outflow
+                            HydState &hs,  // solver's hydraulic state
+                            Network *nw)   // network being analyzed
 {
   // ... initialize which elements have the maximum errors
   maxFlowErr = 0.0;
@@ -47,17 +54,17 @@ double HydBalance::evaluate(double lamda, // step size
 
   // ... initialize nodal flow imbalances to 0
 
-  int nodeCount = nw->count(Element::NODE);
+  int nodeCount = hs.nodeCount;
   memset(&xQ[0], 0, nodeCount * sizeof(double));
 
   // ... find the error norm in satisfying conservation of energy
   //     (updating xQ with internal link flows)
 
-  double norm = findHeadErrorNorm(lamda, dH, dQ, xQ, nw);
+  double norm = findHeadErrorNorm(lamda, dH, dQ, xQ, hs, nw);
 
   // ... update xQ with external outflows
 
-  findNodeOutflows(lamda, dH, xQ, nw);
+  findNodeOutflows(lamda, dH, xQ, hs, nw);
 
   // ... add the error norm in satisfying conservation of flow
 
@@ -65,7 +72,7 @@ double HydBalance::evaluate(double lamda, // step size
 
   // ... evaluate the total relative flow change
 
-  totalFlowChange = findTotalFlowChange(lamda, dQ, nw);
+  totalFlowChange = findTotalFlowChange(lamda, dQ, hs);
 
   // ... return the root mean square error
 
@@ -77,27 +84,28 @@ double HydBalance::evaluate(double lamda, // step size
 //  Find the error norm in satisfying the head loss equation across each link.
 
 double HydBalance::findHeadErrorNorm(double lamda, double dH[], double dQ[],
-                                     double xQ[], Network *nw) {
+                                     double xQ[], HydState &hs, Network *nw) {
   double norm = 0.0;
   double count = 0.0;
   maxHeadErr = 0.0;
   maxFlowChange = 0.0;
   maxFlowChangeLink = 0;
 
-  int linkCount = nw->count(Element::LINK);
+  int linkCount = hs.linkCount;
+  double *trialFlow = hs.trialFlow.data();
   for (int i = 0; i < linkCount; i++) {
     // ... identify link's end nodes
 
-    Link *link = nw->link(i);
-    int n1 = link->fromNode->index;
-    int n2 = link->toNode->index;
+    int n1 = hs.fromNode[i];
+    int n2 = hs.toNode[i];
 
     // ... apply updated flow to end node flow balances
 
     double flowChange = lamda * dQ[i];
-    double flow = link->flow + flowChange;
+    double flow = hs.flow[i] + flowChange;
     xQ[n1] -= flow;
     xQ[n2] += flow;
+    trialFlow[i] = flow;
 
     // ... update network's max. flow change
 
@@ -106,20 +114,40 @@ double HydBalance::findHeadErrorNorm(double lamda, double dH[], double dQ[],
       maxFlowChange = err;
       maxFlowChangeLink = i;
     }
+  }
 
-    // ... compute head loss and its gradient (head loss is saved
-    // ... to link->hLoss and its gradient to link->hGrad)
-    //*******************************************************************
-    link->findHeadLoss(nw, flow);
-    //*******************************************************************
+  // ... compute head losses and their gradients: a batched call to the
+  //     head loss model for open pipes, the link objects for the others
+  //*******************************************************************
+  int batchCount = (int)hs.batchLinks.size();
+  const int *batchLinks = hs.batchLinks.data();
+  for (int k = 0; k < batchCount; k++)
+    hs.batchFlow[k] = trialFlow[batchLinks[k]];
+  nw->headLossModel->findHeadLosses(hs.pipeBatch(), hs.batchFlow.data(),
+                                    hs.batchHLoss.data(),
+                                    hs.batchHGrad.data());
+  for (int k = 0; k < batchCount; k++) {
+    hs.hLoss[batchLinks[k]] = hs.batchHLoss[k];
+    hs.hGrad[batchLinks[k]] = hs.batchHGrad[k];
+  }
+  for (int i : hs.objectLinks) {
+    Link *link = nw->link(i);
+    link->findHeadLoss(nw, trialFlow[i]);
+    hs.hLoss[i] = link->hLoss;
+    hs.hGrad[i] = link->hGrad;
+  }
+  //*******************************************************************
 
+  for (int i = 0; i < linkCount; i++) {
     // ... evaluate head loss error
 
-    double h1 = link->fromNode->head + lamda * dH[n1];
-    double h2 = link->toNode->head + lamda * dH[n2];
-    if (link->hGrad == 0.0)
-      link->hLoss = h1 - h2;
-    err = h1 - h2 - link->hLoss;
+    int n1 = hs.fromNode[i];
+    int n2 = hs.toNode[i];
+    double h1 = hs.head[n1] + lamda * dH[n1];
+    double h2 = hs.head[n2] + lamda * dH[n2];
+    if (hs.hGrad[i] == 0.0)
+      hs.hLoss[i] = h1 - h2;
+    double err = h1 - h2 - hs.hLoss[i];
     if (abs(err) > maxHeadErr) {
       maxHeadErr = abs(err);
       maxHeadErrLink = i;
@@ -143,42 +171,44 @@ double HydBalance::findHeadErrorNorm(double lamda, double dH[], double dQ[],
 
 //  Find net external outflow at each network node.
 
-void findNodeOutflows(double lamda, double dH[], double xQ[], Network *nw) {
+void findNodeOutflows(double lamda, double dH[], double xQ[], HydState &hs,
+                      Network *nw) {
   // ... initialize node outflows and their gradients w.r.t. head
 
-  for (Node *node : nw->nodes) {
-    node->outflow = 0.0;
-    node->qGrad = 0.0;
-  }
+  int nodeCount = hs.nodeCount;
+  double *outflow = hs.outflow.data();
+  double *qGrad = hs.qGrad.data();
+  memset(outflow, 0, nodeCount * sizeof(double));
+  memset(qGrad, 0, nodeCount * sizeof(double));
 
   // ... find pipe leakage flows & assign them to node outflows
 
   if (nw->leakageModel)
-    findLeakageFlows(lamda, dH, xQ, nw);
+    findLeakageFlows(lamda, dH, xQ, hs, nw);
 
   // ... add emitter flows and demands to node outflows
 
-  int nodeCount = nw->count(Element::NODE);
   for (int i = 0; i < nodeCount; i++) {
-    Node *node = nw->node(i);
-    double h = node->head + lamda * dH[i];
+    double h = hs.head[i] + lamda * dH[i];
     double q = 0.0;
     double dqdh = 0.0;
 
     // ... for junctions, outflow depends on head
 
-    if (node->type() == Node::JUNCTION) {
+    if (hs.nodeType[i] == Node::JUNCTION) {
+      Node *node = nw->node(i);
+
       // ... contribution from emitter flow
 
       q = node->findEmitterFlow(h, dqdh);
-      node->qGrad += dqdh;
-      node->outflow += q;
+      qGrad[i] += dqdh;
+      outflow[i] += q;
       xQ[i] -= q;
 
       // ... contribution from demand flow
 
       // ... for fixed grade junction, demand is remaining flow excess
-      if (node->fixedGrade) {
+      if (hs.fixedGrade[i]) {
         q = xQ[i];
         xQ[i] -= q;
       }
@@ -186,17 +216,17 @@ void findNodeOutflows(double lamda, double dH[], double xQ[], Network *nw) {
       // ... otherwise junction has pressure-dependent demand
       else {
         q = node->findActualDemand(nw, h, dqdh);
-        node->qGrad += dqdh;
+        qGrad[i] += dqdh;
         xQ[i] -= q;
       }
       node->actualDemand = q;
-      node->outflow += q;
+      outflow[i] += q;
     }
 
     // ... for tanks and reservoirs all flow excess becomes outflow
 
     else {
-      node->outflow = xQ[i];
+      outflow[i] = xQ[i];
       xQ[i] = 0.0;
     }
   }
@@ -236,7 +266,8 @@ double HydBalance::findFlowErrorNorm(double xQ[], Network *nw) {
 
 //  Assign the leakage flow along each network pipe to its end nodes.
 
-void findLeakageFlows(double lamda, double dH[], double xQ[], Network *nw) {
+void findLeakageFlows(double lamda, double dH[], double xQ[], HydState &hs,
+                      Network *nw) {
   double dqdh = 0.0; // gradient of leakage outflow w.r.t. pressure head
 
   for (Link *link : nw->links) {
@@ -263,8 +294,8 @@ void findLeakageFlows(double lamda, double dH[], double xQ[], Network *nw) {
 
     // ... find link's average pressure head
 
-    double h1 = node1->head + lamda * dH[n1] - node1->elev;
-    double h2 = node2->head + lamda * dH[n2] - node2->elev;
+    double h1 = hs.head[n1] + lamda * dH[n1] - node1->elev;
+    double h2 = hs.head[n2] + lamda * dH[n2] - node2->elev;
     double h = (h1 + h2) / 2.0;
     if (h <= 0.0)
       continue;
@@ -283,13 +314,13 @@ void findLeakageFlows(double lamda, double dH[], double xQ[], Network *nw) {
     // ... add leakage to each node's outflow
 
     if (h1 > 0.0 && canLeak1) {
-      node1->outflow += q;
-      node1->qGrad += dqdh;
+      hs.outflow[n1] += q;
+      hs.qGrad[n1] += dqdh;
       xQ[n1] -= q;
     }
     if (h2 > 0.0 && canLeak2) {
-      node2->outflow += q;
-      node2->qGrad += dqdh;
+      hs.outflow[n2] += q;
+      hs.qGrad[n2] += dqdh;
       xQ[n2] -= q;
     }
   }
@@ -299,16 +330,15 @@ void findLeakageFlows(double lamda, double dH[], double xQ[], Network *nw) {
 
 //  Find the sum of all link flow changes relative to the sum of all link flows.
 
-double findTotalFlowChange(double lamda, double dQ[], Network *nw) {
+double findTotalFlowChange(double lamda, double dQ[], HydState &hs) {
   double qSum = 0.0;
   double dqSum = 0.0;
   double dq;
 
-  for (int i = 0; i < nw->count(Element::LINK); i++) {
-    Link *link = nw->link(i);
+  for (int i = 0; i < hs.linkCount; i++) {
     dq = lamda * dQ[i];
     dqSum += abs(dq);
-    qSum += abs(link->flow + dq);
+    qSum += abs(hs.flow[i] + dq);
   }
   if (qSum > 0.0)
     return dqSum / qSum;
@@ -17,6 +17,7 @@
 #include <vector>
 
 class Network;
+class HydState;
 
 class HydBalanceData {
 public:
@@ -47,9 +48,9 @@ struct HydBalance {
   int maxFlowChangeLink; //!< link with max. flow change
 
   double evaluate(double lamda, double dH[], double dQ[], double xQ[],
-                  Network *nw);
+                  HydState &hs, Network *nw);
   double findHeadErrorNorm(double lamda, double dH[], double dQ[], double xQ[],
-                           Network *nw);
+                           HydState &hs, Network *nw);
   double findFlowErrorNorm(double xQ[], Network *nw);
 
   //! Serialize to JSON for HydBalance
@@ -16,6 +16,7 @@
 #include "hydengine.h"
 #include "Elements/control.h"
 #include "Elements/link.h"
+#include "Elements/node.h"
 #include "Elements/pattern.h"
 #include "Elements/tank.h"
 #include "Solvers/hydsolver.h"
@@ -25,6 +26,7 @@
 #include "network.h"
 
 #include <algorithm>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -228,6 +230,52 @@ void HydEngine::close() {
 
 //-----------------------------------------------------------------------------
 
+size_t HydEngine::dataSize() const {
+  return matrixSolverOffset() + matrixSolver->dataSize();
+}
+
+//-----------------------------------------------------------------------------
+
+size_t HydEngine::matrixSolverOffset() const {
+  return Utilities::alignSize(sizeof(HydEngineData)) + hydSolver->dataSize();
+}
+
+//-----------------------------------------------------------------------------
+
+void HydEngine::copy_to(char *buf) const {
+  HydEngineData data;
+  data.engineState = engineState;
+  data.halted = halted;
+  data.rptTime = rptTime;
+  data.hydStep = hydStep;
+  data.currentTime = currentTime;
+  data.timeOfDay = timeOfDay;
+  data.peakKwatts = peakKwatts;
+  memcpy(buf, &data, sizeof(data));
+  buf += Utilities::alignSize(sizeof(HydEngineData));
+  hydSolver->copy_to(buf);
+  matrixSolver->copy_to(buf + hydSolver->dataSize());
+}
+
+//-----------------------------------------------------------------------------
+
+void HydEngine::copy_from(const char *buf) {
+  HydEngineData data;
+  memcpy(&data, buf, sizeof(data));
+  engineState = static_cast<EngineState>(data.engineState);
+  halted = data.halted;
+  rptTime = data.rptTime;
+  hydStep = data.hydStep;
+  currentTime = data.currentTime;
+  timeOfDay = data.timeOfDay;
+  peakKwatts = data.peakKwatts;
+  buf += Utilities::alignSize(sizeof(HydEngineData));
+  hydSolver->copy_from(buf);
+  matrixSolver->copy_from(buf + hydSolver->dataSize());
+}
+
+//-----------------------------------------------------------------------------
+
 //  Initializes the matrix equation solver.
 
 void HydEngine::initMatrixSolver() {
@@ -243,10 +291,24 @@ void HydEngine::initMatrixSolver() {
       node2[k] = network->link(k)->toNode->index;
     }
 
+    // ... select the row ordering method, passing the node coordinates
+    //     for a nested dissection
+
+    vector<double> xCoord(nodeCount);
+    vector<double> yCoord(nodeCount);
+    for (int i = 0; i < nodeCount; i++) {
+      xCoord[i] = network->node(i)->xCoord;
+      yCoord[i] = network->node(i)->yCoord;
+    }
+    matrixSolver->setOrdering(network->option(Options::MATRIX_ORDERING),
+                              xCoord, yCoord);
+
     // ...  initialize the matrix solver
 
     matrixSolver->init(nodeCount, linkCount, (int *)&node1[0],
                        (int *)&node2[0]);
+    if (network->option(Options::REPORT_STATUS))
+      matrixSolver->debug(network->msgLog);
   } catch (...) {
     throw;
   }
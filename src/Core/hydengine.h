@@ -27,8 +27,6 @@ public:
   int currentTime;
   int timeOfDay;
   double peakKwatts;
-  HydSolverData hydSolver;
-  MatrixSolverData matrixSolver;
 };
 
 //! \class HydEngine
@@ -84,29 +82,16 @@ public:
     peakKwatts = j.at("peakKwatts").get<double>();
   }
 
-  void copy_to(HydEngineData &data) const {
-    data.engineState = engineState;
-    data.halted = halted;
-    data.rptTime = rptTime;
-    data.hydStep = hydStep;
-    data.currentTime = currentTime;
-    data.timeOfDay = timeOfDay;
-    data.peakKwatts = peakKwatts;
-    hydSolver->copy_to(data.hydSolver);
-    matrixSolver->copy_to(data.matrixSolver);
-  }
+  // Size (bytes) of the engine's state in a flat snapshot: HydEngineData
+  // followed by the states of the hydraulic and matrix solvers
+  size_t dataSize() const;
 
-  void copy_from(const HydEngineData &data) {
-    engineState = static_cast<EngineState>(data.engineState);
-    halted = data.halted;
-    rptTime = data.rptTime;
-    hydStep = data.hydStep;
-    currentTime = data.currentTime;
-    timeOfDay = data.timeOfDay;
-    peakKwatts = data.peakKwatts;
-    hydSolver->copy_from(data.hydSolver);
-    matrixSolver->copy_from(data.matrixSolver);
-  }
+  // Offset (bytes) of the matrix solver's state in the engine's snapshot
+  size_t matrixSolverOffset() const;
+
+  // Copies the engine's state to/from a flat snapshot buffer
+  void copy_to(char *buf) const;
+  void copy_from(const char *buf);
 
 private:
   // Engine state
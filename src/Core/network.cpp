@@ -16,6 +16,8 @@
 #include "Elements/link.h"
 #include "Elements/node.h"
 #include "Elements/pattern.h"
+#include "Elements/pump.h"
+#include "Elements/tank.h"
 #include "Models/demandmodel.h"
 #include "Models/headlossmodel.h"
 #include "Models/leakagemodel.h"
@@ -23,8 +25,16 @@
 #include "Utilities/mempool.h"
 #include "error.h"
 
+#include <type_traits>
+
 using namespace std;
 
+static_assert(is_trivially_copyable<NodeData>::value &&
+                  is_trivially_copyable<TankData>::value &&
+                  is_trivially_copyable<LinkData>::value &&
+                  is_trivially_copyable<PumpData>::value,
+              "snapshot data must be trivially copyable");
+
 //-----------------------------------------------------------------------------
 
 // Constructor
@@ -71,6 +81,14 @@ void Network::clear() {
   for (Control *control : controls)
     control->~Control();
   controls.clear();
+  nodeTable.clear();
+  linkTable.clear();
+  patternTable.clear();
+  curveTable.clear();
+  controlTable.clear();
+  stateTanks.clear();
+  statePumps.clear();
+  stateIndexed = false;
 
   // ... reclaim all memory allocated by the memory pool
 
@@ -86,6 +104,133 @@ void Network::clear() {
 
 //-----------------------------------------------------------------------------
 
+void Network::clone(Network *source) {
+  clear();
+  title = source->title;
+  units = source->units;
+  options = source->options;
+  qualBalance = source->qualBalance;
+  graph = source->graph;
+
+  // ... patterns and curves come first since nodes, links and controls
+  //     refer to them by index (as do links to nodes)
+
+  for (Pattern *pattern : source->patterns) {
+    patterns.push_back(pattern->clone(&memPool));
+    patternTable[pattern->name] = patterns.back();
+  }
+  for (Curve *curve : source->curves) {
+    curves.push_back(curve->clone(&memPool));
+    curveTable[curve->name] = curves.back();
+  }
+  for (Node *node : source->nodes) {
+    nodes.push_back(node->clone(this, &memPool));
+    nodeTable[node->name] = nodes.back();
+  }
+  for (Link *link : source->links) {
+    links.push_back(link->clone(this, &memPool));
+    linkTable[link->name] = links.back();
+  }
+  for (Control *control : source->controls) {
+    controls.push_back(control->clone(this, &memPool));
+    controlTable[control->name] = controls.back();
+  }
+
+  // ... computational sub-models are created when the hydraulic and
+  //     water quality engines are opened
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the tanks and pumps whose extra state goes into a snapshot (done once,
+//  so that saving and restoring a snapshot needs no virtual calls).
+
+void Network::indexState() const {
+  if (stateIndexed)
+    return;
+  stateTanks.clear();
+  statePumps.clear();
+  for (Node *node : nodes)
+    if (node->type() == Node::TANK)
+      stateTanks.push_back(static_cast<Tank *>(node));
+  for (Link *link : links)
+    if (link->type() == Link::PUMP)
+      statePumps.push_back(static_cast<Pump *>(link));
+  stateIndexed = true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  The network's state is stored as consecutive arrays of NodeData, TankData,
+//  LinkData, PumpData and pattern periods (each one aligned for doubles).
+
+NetworkData Network::dataLayout() const {
+  indexState();
+  NetworkData layout;
+  layout.nodes = 0;
+  layout.tanks =
+      layout.nodes + Utilities::alignSize(nodes.size() * sizeof(NodeData));
+  layout.links =
+      layout.tanks + Utilities::alignSize(stateTanks.size() * sizeof(TankData));
+  layout.pumps =
+      layout.links + Utilities::alignSize(links.size() * sizeof(LinkData));
+  layout.patterns =
+      layout.pumps + Utilities::alignSize(statePumps.size() * sizeof(PumpData));
+  layout.size =
+      layout.patterns + Utilities::alignSize(patterns.size() * sizeof(int));
+  return layout;
+}
+
+//-----------------------------------------------------------------------------
+
+void Network::copy_to(char *buf) const {
+  NetworkData layout = dataLayout();
+  NodeData *nodeData = reinterpret_cast<NodeData *>(buf + layout.nodes);
+  TankData *tankData = reinterpret_cast<TankData *>(buf + layout.tanks);
+  LinkData *linkData = reinterpret_cast<LinkData *>(buf + layout.links);
+  PumpData *pumpData = reinterpret_cast<PumpData *>(buf + layout.pumps);
+  int *patternData = reinterpret_cast<int *>(buf + layout.patterns);
+
+  for (size_t i = 0; i < nodes.size(); ++i)
+    nodes[i]->copy_to(nodeData[i]);
+  for (size_t i = 0; i < stateTanks.size(); ++i)
+    stateTanks[i]->copy_to(tankData[i]);
+  for (size_t i = 0; i < links.size(); ++i)
+    links[i]->copy_to(linkData[i]);
+  for (size_t i = 0; i < statePumps.size(); ++i)
+    statePumps[i]->copy_to(pumpData[i]);
+  for (size_t i = 0; i < patterns.size(); ++i)
+    patternData[i] = patterns[i]->currentIdx();
+}
+
+//-----------------------------------------------------------------------------
+
+void Network::copy_from(const char *buf) {
+  NetworkData layout = dataLayout();
+  const NodeData *nodeData =
+      reinterpret_cast<const NodeData *>(buf + layout.nodes);
+  const TankData *tankData =
+      reinterpret_cast<const TankData *>(buf + layout.tanks);
+  const LinkData *linkData =
+      reinterpret_cast<const LinkData *>(buf + layout.links);
+  const PumpData *pumpData =
+      reinterpret_cast<const PumpData *>(buf + layout.pumps);
+  const int *patternData = reinterpret_cast<const int *>(buf + layout.patterns);
+
+  for (size_t i = 0; i < nodes.size(); ++i)
+    nodes[i]->copy_from(nodeData[i]);
+  for (size_t i = 0; i < stateTanks.size(); ++i)
+    stateTanks[i]->copy_from(tankData[i]);
+  for (size_t i = 0; i < links.size(); ++i)
+    links[i]->copy_from(linkData[i]);
+  for (size_t i = 0; i < statePumps.size(); ++i)
+    statePumps[i]->copy_from(pumpData[i]);
+  for (size_t i = 0; i < patterns.size(); ++i)
+    patterns[i]->currentIdx() = patternData[i];
+}
+
+//-----------------------------------------------------------------------------
+
 int Network::count(Element::ElementType eType) {
   switch (eType) {
   case Element::NODE:
@@ -203,6 +348,7 @@ bool Network::addElement(Element::ElementType element, int type, string name) {
   //       already contain an element with the same name.
 
   try {
+    stateIndexed = false;
     if (element == Element::NODE) {
       Node *node = Node::factory(type, name, &memPool);
       node->index = nodes.size();
@@ -33,11 +33,16 @@
 #include <unordered_map>
 #include <vector>
 
+//! Layout of a network's state in a flat snapshot: byte offsets of the
+//! contiguous arrays of trivially copyable element data.
 class NetworkData {
 public:
-  std::vector<NodeData> nodes;
-  std::vector<LinkData> links;
-  std::vector<int> patterns; // indices of patterns
+  size_t nodes;    //!< NodeData of every node
+  size_t tanks;    //!< TankData of every tank
+  size_t links;    //!< LinkData of every link
+  size_t pumps;    //!< PumpData of every pump
+  size_t patterns; //!< current period of every pattern
+  size_t size;     //!< total size (bytes)
 };
 
 //! \class Network
@@ -54,6 +59,9 @@ public:
   // Clears all elements from the network
   void clear();
 
+  // Replaces the contents of the network with a deep copy of another one
+  void clone(Network *source);
+
   // Adds an element to the network
   bool addElement(Element::ElementType eType, int subType, std::string name);
 
@@ -165,32 +173,12 @@ public:
     }
   }
 
-  void copy_to(NetworkData &data) const {
-    // resize data vectors to match network size
-    if (data.nodes.size() < nodes.size())
-      data.nodes.resize(nodes.size());
-    if (data.links.size() < links.size())
-      data.links.resize(links.size());
-    if (data.patterns.size() < patterns.size())
-      data.patterns.resize(patterns.size());
-
-    // copy data
-    for (size_t i = 0; i < nodes.size(); ++i)
-      nodes[i]->copy_to(data.nodes[i]);
-    for (size_t i = 0; i < links.size(); ++i)
-      links[i]->copy_to(data.links[i]);
-    for (size_t i = 0; i < patterns.size(); ++i)
-      data.patterns[i] = patterns[i]->currentIdx();
-  }
+  // Size (bytes) and layout of the network's state in a flat snapshot
+  NetworkData dataLayout() const;
 
-  void copy_from(const NetworkData &data) {
-    for (size_t i = 0; i < nodes.size(); ++i)
-      nodes[i]->copy_from(data.nodes[i]);
-    for (size_t i = 0; i < links.size(); ++i)
-      links[i]->copy_from(data.links[i]);
-    for (size_t i = 0; i < patterns.size(); ++i)
-      patterns[i]->currentIdx() = data.patterns[i];
-  }
+  // Copies the network's state to/from a flat snapshot buffer
+  void copy_to(char *buf) const;
+  void copy_from(const char *buf);
 
 private:
   // Hash tables that associate an element's ID name with its storage index.
@@ -205,6 +193,13 @@ private:
   std::unordered_map<std::string, Element *>
       controlTable; //!< hash table for control ID names.
   MemPool memPool;  //!< memory pool for network objects
+
+  // Tanks and pumps whose extra state is saved in a snapshot (found
+  // when the first snapshot is taken)
+  mutable std::vector<Tank *> stateTanks;
+  mutable std::vector<Pump *> statePumps;
+  mutable bool stateIndexed = false;
+  void indexState() const;
 };
 
 //-----------------------------------------------------------------------------
@@ -37,9 +37,18 @@ static const char *pressureUnitsWords[] = {"PSI", "METERS", "PKA", 0};
 // Headloss formula keywords
 static const char *headlossModelWords[] = {"H-W", "D-W", "C-M", 0};
 
+// Hydraulic solver method names
+static const char *hydSolverWords[] = {"GGA", "NULLSPACE", 0};
+
 // Hydraulic Newton solver step size method names
 static const char *stepSizingWords[] = {"FULL", "RELAXATION", "LINESEARCH", 0};
 
+// Sparse matrix solver names
+static const char *matrixSolverWords[] = {"SPARSPAK", "SUPERNODAL", 0};
+
+// Sparse matrix row ordering method names
+static const char *matrixOrderingWords[] = {"MMD", "ND", 0};
+
 static const char *ifUnbalancedWords[] = {"STOP", "CONTINUE", 0};
 
 // Demand model keywords
@@ -77,6 +86,7 @@ void Options::setDefaults() {
   stringOptions[HYD_SOLVER] = "GGA";
   stringOptions[STEP_SIZING] = "FULL";
   stringOptions[MATRIX_SOLVER] = "SPARSPAK";
+  stringOptions[MATRIX_ORDERING] = "MMD";
   stringOptions[DEMAND_PATTERN_NAME] = "";
   stringOptions[QUAL_MODEL] = "NONE";
   stringOptions[QUAL_NAME] = "Chemical";
@@ -157,6 +167,13 @@ int Options::setOption(StringOption option, const string &value) {
     stringOptions[HEADLOSS_MODEL] = headlossModelWords[i];
     break;
 
+  case HYD_SOLVER:
+    i = Utilities::findFullMatch(value, hydSolverWords);
+    if (i < 0)
+      return InputError::INVALID_KEYWORD;
+    stringOptions[HYD_SOLVER] = hydSolverWords[i];
+    break;
+
   case STEP_SIZING:
     i = Utilities::findFullMatch(value, stepSizingWords);
     if (i < 0)
@@ -164,6 +181,20 @@ int Options::setOption(StringOption option, const string &value) {
     stringOptions[STEP_SIZING] = stepSizingWords[i];
     break;
 
+  case MATRIX_SOLVER:
+    i = Utilities::findFullMatch(value, matrixSolverWords);
+    if (i < 0)
+      return InputError::INVALID_KEYWORD;
+    stringOptions[MATRIX_SOLVER] = matrixSolverWords[i];
+    break;
+
+  case MATRIX_ORDERING:
+    i = Utilities::findFullMatch(value, matrixOrderingWords);
+    if (i < 0)
+      return InputError::INVALID_KEYWORD;
+    stringOptions[MATRIX_ORDERING] = matrixOrderingWords[i];
+    break;
+
   case DEMAND_MODEL:
     i = Utilities::findFullMatch(value, demandModelWords);
     if (i < 0)
@@ -49,6 +49,7 @@ public:
     HYD_SOLVER,          //!< Name of hydraulic solver method
     STEP_SIZING,         //!< Name of Newton step size method
     MATRIX_SOLVER,       //!< Name of sparse matrix eqn. solver
+    MATRIX_ORDERING,     //!< Name of sparse matrix row ordering method
     DEMAND_PATTERN_NAME, //!< Name of global demand pattern
 
     QUAL_MODEL,      //!< Name of water quality model used
@@ -68,6 +68,27 @@ int Project::load(const char *fname) {
 
 //-----------------------------------------------------------------------------
 
+//  Load a project with an in-memory copy of another project's network
+//  (its solvers are opened anew by initSolver).
+
+int Project::clone(Project *source) {
+  try {
+    clear();
+    if (source->networkEmpty)
+      return 0;
+    inpFileName = source->inpFileName;
+    network.clone(&source->network);
+    networkEmpty = false;
+    runQuality = source->runQuality;
+    return 0;
+  } catch (ENerror const &e) {
+    writeMsg(e.msg);
+    return e.code;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
 //  Save the project to a file.
 
 int Project::save(const char *fname) {
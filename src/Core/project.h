@@ -29,12 +29,30 @@
 #include "Utilities/utilities.h"
 
 #include <fstream>
+#include <stdexcept>
 #include <string>
+#include <vector>
+
+//! \class ProjectData
+//! \brief A flat, trivially copyable snapshot of a project's simulation state.
+//!
+//! The state of the network (see Network::dataLayout) is followed by that of
+//! the hydraulic engine in a single buffer, so a snapshot can be copied with
+//! memcpy or sent in one MPI message (data(), size()) to a project opened
+//! on the same network.
 
 class ProjectData {
 public:
-  NetworkData network;
-  HydEngineData hydEngine;
+  char *data() { return arena.data(); }
+  const char *data() const { return arena.data(); }
+  size_t size() const { return arena.size(); }
+  void resize(size_t n) { arena.resize(n); }
+
+  size_t hydEngine = 0;    //!< offset of the hydraulic engine's state
+  size_t matrixSolver = 0; //!< offset of the matrix solver's coeffs.
+
+private:
+  std::vector<char> arena;
 };
 
 namespace Epanet {
@@ -55,6 +73,7 @@ public:
 
   int load(const char *fname);
   int save(const char *fname);
+  int clone(Project *source);
   void clear();
 
   int initSolver(bool initFlows);
@@ -73,6 +92,7 @@ public:
   void writeMsgLog(std::ostream &out);
   void writeMsgLog();
   Network *getNetwork() { return &network; }
+  int getElapsedTime() { return hydEngine.getElapsedTime(); }
 
   //! Serialize to JSON
   nlohmann::json to_json() const {
@@ -85,14 +105,33 @@ public:
     hydEngine.from_json(j.at("hydEngine"));
   }
 
+  //! Size (bytes) of a snapshot of the project's simulation state
+  size_t dataSize() const {
+    return network.dataLayout().size + hydEngine.dataSize();
+  }
+
+  //! Saves the simulation state to a snapshot (sized on first use)
   void copy_to(ProjectData &data) const {
-    network.copy_to(data.network);
-    hydEngine.copy_to(data.hydEngine);
+    size_t networkSize = network.dataLayout().size;
+    if (data.size() != networkSize + hydEngine.dataSize()) {
+      data.resize(networkSize + hydEngine.dataSize());
+      data.hydEngine = networkSize;
+      data.matrixSolver = networkSize + hydEngine.matrixSolverOffset();
+    }
+    network.copy_to(data.data());
+    hydEngine.copy_to(data.data() + data.hydEngine);
   }
 
-  void copy_from(ProjectData &data) {
-    network.copy_from(data.network);
-    hydEngine.copy_from(data.hydEngine);
+  //! Restores the simulation state from a snapshot taken of a project
+  //! opened on the same network (throws if its layout differs)
+  void copy_from(const ProjectData &data) {
+    size_t networkSize = network.dataLayout().size;
+    if (data.size() != networkSize + hydEngine.dataSize() ||
+        data.hydEngine != networkSize ||
+        data.matrixSolver != networkSize + hydEngine.matrixSolverOffset())
+      throw std::runtime_error("Snapshot does not match the project's layout.");
+    network.copy_from(data.data());
+    hydEngine.copy_from(data.data() + data.hydEngine);
   }
 
 private:
@@ -39,6 +39,17 @@ Control::~Control() {}
 
 //-----------------------------------------------------------------------------
 
+Control *Control::clone(Network *nw, MemPool *memPool) const {
+  Control *control = new (memPool->alloc(sizeof(Control))) Control(*this);
+  if (link)
+    control->link = nw->link(link->index);
+  if (node)
+    control->node = nw->node(node->index);
+  return control;
+}
+
+//-----------------------------------------------------------------------------
+
 void Control::setProperties(int controlType, Link *controlLink, int linkStatus,
                             double linkSetting, Node *controlNode,
                             double nodeSetting, int controlLevelType,
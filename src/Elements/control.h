@@ -20,6 +20,7 @@
 #include <string>
 
 class Network;
+class MemPool;
 
 //! \class Control
 //! \brief A class that controls pumps and valves based on a single condition.
@@ -40,6 +41,10 @@ public:
   Control(int type_, std::string name_);
   ~Control();
 
+  // Makes a copy of the control (allocated from memPool) that acts on
+  // the elements of network nw
+  Control *clone(Network *nw, MemPool *memPool) const;
+
   // Applies all pressure controls to the pipe network,
   // return true if status of any link changes
   static bool applyPressureControls(Network *network);
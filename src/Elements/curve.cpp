@@ -7,6 +7,7 @@
  */
 
 #include "curve.h"
+#include "Utilities/mempool.h"
 #include "Utilities/utilities.h"
 
 #include <iomanip>
@@ -26,6 +27,10 @@ Curve::~Curve() {
   yData.clear();
 }
 
+Curve *Curve::clone(MemPool *memPool) const {
+  return new (memPool->alloc(sizeof(Curve))) Curve(*this);
+}
+
 //-----------------------------------------------------------------------------
 
 void Curve::findSegment(double xseg, double &slope, double &intercept) {
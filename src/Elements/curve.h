@@ -19,6 +19,8 @@
 #include <string>
 #include <vector>
 
+class MemPool;
+
 //! \class Curve
 //! \brief An ordered collection of x,y data pairs.
 //!
@@ -41,6 +43,9 @@ public:
   Curve(std::string name_);
   ~Curve();
 
+  // Makes a copy of the curve allocated from memPool
+  Curve *clone(MemPool *memPool) const;
+
   // Data provider methods
   void setType(int curveType);
   void addData(double x, double y);
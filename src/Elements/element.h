@@ -35,9 +35,13 @@ public:
   //! Deserialize from JSON for Element
   virtual void from_json(const nlohmann::json &j) = 0;
 
+protected:
+  // Elements can only be copied by their own clone() methods (see
+  // Network::clone), which re-map the pointers they hold
+  Element(const Element &e) = default;
+
 private:
-  // Elements can't be copied or tested for equality
-  Element(const Element &e);
+  // Elements can't be assigned or tested for equality
   Element &operator=(const Element &e);
 };
 
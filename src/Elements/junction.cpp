@@ -27,6 +27,30 @@ Junction::~Junction() {
   delete emitter;
 }
 
+//-----------------------------------------------------------------------------
+//    Copy a junction into network nw
+//-----------------------------------------------------------------------------
+Node *Junction::clone(Network *nw, MemPool *memPool) const {
+  Junction *junc = new (memPool->alloc(sizeof(Junction))) Junction(*this);
+  junc->cloneQualSource(nw);
+
+  // ... demands and emitter point to the time patterns of network nw
+
+  if (primaryDemand.timePattern)
+    junc->primaryDemand.timePattern =
+        nw->pattern(primaryDemand.timePattern->index);
+  for (Demand &demand : junc->demands) {
+    if (demand.timePattern)
+      demand.timePattern = nw->pattern(demand.timePattern->index);
+  }
+  if (emitter) {
+    junc->emitter = new Emitter(*emitter);
+    if (emitter->timePattern)
+      junc->emitter->timePattern = nw->pattern(emitter->timePattern->index);
+  }
+  return junc;
+}
+
 //-----------------------------------------------------------------------------
 //    Convert junction properties from user's input units to internal units
 //    (called after loading network data from an input file)
@@ -28,6 +28,7 @@ public:
   Junction(std::string name_);
   ~Junction();
 
+  Node *clone(Network *nw, MemPool *memPool) const;
   int type() { return Node::JUNCTION; }
   void convertUnits(Network *nw);
   void initialize(Network *nw);
@@ -41,6 +41,13 @@ Link::~Link() {}
 
 //-----------------------------------------------------------------------------
 
+void Link::cloneEndNodes(Network *nw) {
+  fromNode = nw->node(fromNode->index);
+  toNode = nw->node(toNode->index);
+}
+
+//-----------------------------------------------------------------------------
+
 /// Factory Method
 
 Link *Link::factory(int type_, string name_, MemPool *memPool) {
@@ -17,9 +17,6 @@ public:
   int initStatus;
   double setting;
   int status;
-  double speed;
-  double costPerKwh;
-  PumpEnergyData pumpEnergy;
 };
 
 class Network;
@@ -38,6 +35,10 @@ public:
 
   static Link *factory(int type_, std::string name_, MemPool *memPool);
 
+  // Makes a copy of the link (allocated from memPool) whose pointers
+  // refer to the elements of network nw
+  virtual Link *clone(Network *nw, MemPool *memPool) const = 0;
+
   virtual int type() = 0;
   virtual std::string typeStr() = 0;
   virtual void convertUnits(Network *nw) = 0;
@@ -126,7 +127,7 @@ public:
     setting = j.at("setting").get<double>();
   }
 
-  virtual void copy_to(LinkData &data) const {
+  void copy_to(LinkData &data) const {
     data.initStatus = initStatus;
     data.initSetting = initSetting;
     data.status = status;
@@ -136,7 +137,7 @@ public:
     data.setting = setting;
   }
 
-  virtual void copy_from(const LinkData &data) {
+  void copy_from(const LinkData &data) {
     initStatus = data.initStatus;
     initSetting = data.initSetting;
     status = data.status;
@@ -145,6 +146,12 @@ public:
     hGrad = data.hGrad;
     setting = data.setting;
   }
+
+protected:
+  Link(const Link &link) = default;
+
+  // Points the link's end nodes to those of network nw
+  void cloneEndNodes(Network *nw);
 };
 
 #endif
@@ -6,6 +6,7 @@
  */
 
 #include "node.h"
+#include "Core/network.h"
 #include "Utilities/mempool.h"
 #include "junction.h"
 #include "qualsource.h"
@@ -50,6 +51,16 @@ Node *Node::factory(int type_, string name_, MemPool *memPool) {
 
 //-----------------------------------------------------------------------------
 
+void Node::cloneQualSource(Network *nw) {
+  if (qualSource == nullptr)
+    return;
+  qualSource = new QualSource(*qualSource);
+  if (qualSource->pattern)
+    qualSource->pattern = nw->pattern(qualSource->pattern->index);
+}
+
+//-----------------------------------------------------------------------------
+
 void Node::initialize(Network *nw) {
   head = elev;
   quality = initQual;
@@ -14,19 +14,6 @@ public:
   double fullDemand;
   double actualDemand;
   double outflow;
-  double initHead;
-  double minHead;
-  double maxHead;
-  double diameter;
-  double minVolume;
-  double bulkCoeff;
-  double maxVolume;
-  double volume;
-  double area;
-  double ucfLength;
-  double pastHead;
-  double pastVolume;
-  double pastOutflow;
 };
 
 class Network;
@@ -42,6 +29,10 @@ public:
 
   static Node *factory(int type_, std::string name_, MemPool *memPool);
 
+  // Makes a copy of the node (allocated from memPool) whose pointers
+  // refer to the elements of network nw
+  virtual Node *clone(Network *nw, MemPool *memPool) const = 0;
+
   virtual int type() = 0;
   virtual void convertUnits(Network *nw) = 0;
   virtual void initialize(Network *nw);
@@ -102,7 +93,7 @@ public:
     outflow = j.at("outflow").get<double>();
   }
 
-  virtual void copy_to(NodeData &data) const {
+  void copy_to(NodeData &data) const {
     data.fixedGrade = fixedGrade;
     data.head = head;
     data.qGrad = qGrad;
@@ -111,7 +102,7 @@ public:
     data.outflow = outflow;
   }
 
-  virtual void copy_from(const NodeData &data) {
+  void copy_from(const NodeData &data) {
     fixedGrade = data.fixedGrade;
     head = data.head;
     qGrad = data.qGrad;
@@ -119,6 +110,12 @@ public:
     actualDemand = data.actualDemand;
     outflow = data.outflow;
   }
+
+protected:
+  Node(const Node &node) = default;
+
+  // Replaces the source node's quality source with a copy owned by this node
+  void cloneQualSource(Network *nw);
 };
 
 #endif
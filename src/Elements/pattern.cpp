@@ -58,6 +58,10 @@ FixedPattern::FixedPattern(string name_)
 
 FixedPattern::~FixedPattern() {}
 
+Pattern *FixedPattern::clone(MemPool *memPool) const {
+  return new (memPool->alloc(sizeof(FixedPattern))) FixedPattern(*this);
+}
+
 //-----------------------------------------------------------------------------
 
 //  Initializes the state of a Fixed Pattern.
@@ -102,6 +106,10 @@ VariablePattern::VariablePattern(string name_)
 
 VariablePattern::~VariablePattern() { times.clear(); }
 
+Pattern *VariablePattern::clone(MemPool *memPool) const {
+  return new (memPool->alloc(sizeof(VariablePattern))) VariablePattern(*this);
+}
+
 //-----------------------------------------------------------------------------
 
 //  Initializes the state of a VariablePattern.
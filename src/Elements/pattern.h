@@ -40,6 +40,9 @@ public:
   // Pattern factory
   static Pattern *factory(int type_, std::string name_, MemPool *memPool);
 
+  // Makes a copy of the pattern allocated from memPool
+  virtual Pattern *clone(MemPool *memPool) const = 0;
+
   // Methods
   void setTimeInterval(int t) { interval = t; }
   void addFactor(double f) { factors.push_back(f); }
@@ -94,6 +97,7 @@ public:
   ~FixedPattern();
 
   // Methods
+  Pattern *clone(MemPool *memPool) const;
   void init(int intrvl, int tstart);
   int nextTime(int t);
   void advance(int t);
@@ -117,6 +121,7 @@ public:
   ~VariablePattern();
 
   // Methods
+  Pattern *clone(MemPool *memPool) const;
   void addTime(int t) { times.push_back(t); }
   int time(int i) { return times[i]; }
   void init(int intrvl, int tstart);
@@ -27,6 +27,14 @@ Pipe::~Pipe() {}
 
 //-----------------------------------------------------------------------------
 
+Link *Pipe::clone(Network *nw, MemPool *memPool) const {
+  Pipe *pipe = new (memPool->alloc(sizeof(Pipe))) Pipe(*this);
+  pipe->cloneEndNodes(nw);
+  return pipe;
+}
+
+//-----------------------------------------------------------------------------
+
 void Pipe::convertUnits(Network *nw) {
   diameter /= nw->ucf(Units::DIAMETER);
   length /= nw->ucf(Units::LENGTH);
@@ -28,6 +28,7 @@ public:
 
   // Methods
 
+  Link *clone(Network *nw, MemPool *memPool) const;
   int type() { return Link::PIPE; }
   std::string typeStr() { return "Pipe"; }
   void convertUnits(Network *nw);
@@ -25,6 +25,22 @@ Pump::~Pump() {}
 
 //-----------------------------------------------------------------------------
 
+Link *Pump::clone(Network *nw, MemPool *memPool) const {
+  Pump *pump = new (memPool->alloc(sizeof(Pump))) Pump(*this);
+  pump->cloneEndNodes(nw);
+  if (pumpCurve.curve)
+    pump->pumpCurve.curve = nw->curve(pumpCurve.curve->index);
+  if (speedPattern)
+    pump->speedPattern = nw->pattern(speedPattern->index);
+  if (efficCurve)
+    pump->efficCurve = nw->curve(efficCurve->index);
+  if (costPattern)
+    pump->costPattern = nw->pattern(costPattern->index);
+  return pump;
+}
+
+//-----------------------------------------------------------------------------
+
 void Pump::convertUnits(Network *nw) {
   pumpCurve.horsepower /= nw->ucf(Units::POWER);
 }
@@ -22,6 +22,13 @@ class Network;
 class Pattern;
 class Curve;
 
+class PumpData {
+public:
+  double speed;
+  double costPerKwh;
+  PumpEnergyData pumpEnergy;
+};
+
 //! \class Pump
 //! \brief A Link that raises the head of water flowing through it.
 
@@ -34,6 +41,7 @@ public:
 
   // Methods
 
+  Link *clone(Network *nw, MemPool *memPool) const;
   int type() { return Link::PUMP; }
   std::string typeStr() { return "Pump"; }
   void convertUnits(Network *nw);
@@ -83,15 +91,17 @@ public:
     costPerKwh = j.at("costPerKwh").get<double>();
   }
 
-  void copy_to(LinkData &data) const override {
-    Link::copy_to(data);
+  // The LinkData part of the state is copied by Link::copy_to
+  using Link::copy_to;
+  using Link::copy_from;
+
+  void copy_to(PumpData &data) const {
     data.speed = speed;
     data.costPerKwh = costPerKwh;
     pumpEnergy.copy_to(data.pumpEnergy);
   }
 
-  void copy_from(const LinkData &data) override {
-    Link::copy_from(data);
+  void copy_from(const PumpData &data) {
     speed = data.speed;
     costPerKwh = data.costPerKwh;
     pumpEnergy.copy_from(data.pumpEnergy);
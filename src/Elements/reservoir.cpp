@@ -25,6 +25,16 @@ Reservoir::~Reservoir() {}
 
 //-----------------------------------------------------------------------------
 
+Node *Reservoir::clone(Network *nw, MemPool *memPool) const {
+  Reservoir *resv = new (memPool->alloc(sizeof(Reservoir))) Reservoir(*this);
+  resv->cloneQualSource(nw);
+  if (headPattern)
+    resv->headPattern = nw->pattern(headPattern->index);
+  return resv;
+}
+
+//-----------------------------------------------------------------------------
+
 void Reservoir::convertUnits(Network *nw) {
   elev /= nw->ucf(Units::LENGTH);
   initQual /= nw->ucf(Units::CONCEN);
@@ -32,6 +32,7 @@ public:
   ~Reservoir();
 
   // Methods
+  Node *clone(Network *nw, MemPool *memPool) const;
   int type() { return Node::RESERVOIR; }
   void convertUnits(Network *nw);
   void setFixedGrade();
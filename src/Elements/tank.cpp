@@ -30,6 +30,18 @@ Tank::Tank(string name_)
 
 //-----------------------------------------------------------------------------
 
+//  Copy a tank into network nw
+
+Node *Tank::clone(Network *nw, MemPool *memPool) const {
+  Tank *tank = new (memPool->alloc(sizeof(Tank))) Tank(*this);
+  tank->cloneQualSource(nw);
+  if (volCurve)
+    tank->volCurve = nw->curve(volCurve->index);
+  return tank;
+}
+
+//-----------------------------------------------------------------------------
+
 //  Convert user's input units to internal units
 
 void Tank::convertUnits(Network *nw) {
@@ -18,6 +18,23 @@
 
 #include <string>
 
+class TankData {
+public:
+  double initHead;
+  double minHead;
+  double maxHead;
+  double diameter;
+  double minVolume;
+  double bulkCoeff;
+  double maxVolume;
+  double volume;
+  double area;
+  double ucfLength;
+  double pastHead;
+  double pastVolume;
+  double pastOutflow;
+};
+
 //! \class Tank
 //! \brief A fixed head Node with storage volume.
 //!
@@ -31,6 +48,7 @@ public:
   //~Tank() {}
 
   // Overridden virtual methods
+  Node *clone(Network *nw, MemPool *memPool) const;
   int type() { return Node::TANK; }
   void validate(Network *nw);
   void convertUnits(Network *nw);
@@ -104,8 +122,11 @@ public:
     pastOutflow = j.at("pastOutflow").get<double>();
   }
 
-  virtual void copy_to(NodeData &data) const override {
-    Node::copy_to(data);
+  // The NodeData part of the state is copied by Node::copy_to
+  using Node::copy_to;
+  using Node::copy_from;
+
+  void copy_to(TankData &data) const {
     data.initHead = initHead;
     data.minHead = minHead;
     data.maxHead = maxHead;
@@ -121,8 +142,7 @@ public:
     data.pastOutflow = pastOutflow;
   }
 
-  void copy_from(const NodeData &data) override {
-    Node::copy_from(data);
+  void copy_from(const TankData &data) {
     initHead = data.initHead;
     minHead = data.minHead;
     maxHead = data.maxHead;
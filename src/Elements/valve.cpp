@@ -37,6 +37,14 @@ Valve::~Valve() {}
 
 //-----------------------------------------------------------------------------
 
+Link *Valve::clone(Network *nw, MemPool *memPool) const {
+  Valve *valve = new (memPool->alloc(sizeof(Valve))) Valve(*this);
+  valve->cloneEndNodes(nw);
+  return valve;
+}
+
+//-----------------------------------------------------------------------------
+
 //  Return the string representation of the valve's type.
 
 string Valve::typeStr() { return ValveTypeWords[valveType]; }
@@ -40,6 +40,7 @@ public:
   ~Valve();
 
   // Methods
+  Link *clone(Network *nw, MemPool *memPool) const;
   int type();
   std::string typeStr();
   void convertUnits(Network *nw);
@@ -0,0 +1,552 @@
+// src/Gen/generate.cpp
+//
+// Generator of synthetic networks for scaling experiments (build/gen-epanet3).
+// It writes an INP file in the format of networks/any-town.inp (CMH, H-W, pumps with PATTERN speed
+// controls, PRICES energy pattern) and a constraint spec in the format of networks/any-town.json, so
+// that the generated network runs through bench-epanet3 and run-epanet3 like the bundled ones.
+//
+// Topologies (junctions on a square lattice whose spacing is the mean pipe length):
+//   grid  every lattice edge is a pipe
+//   tree  random spanning tree of the lattice plus a fraction of the remaining edges as loops
+//   dma   district meter areas (tree-with-loops on their own lattice), each fed by one inlet node;
+//         the inlets are joined by a looped trunk main
+//
+// Pipes are sized by the peak flow they carry in a breadth-first tree grown from the sources (pump
+// stations and tanks), at the design velocity, with a lognormal scatter; loop pipes take the smaller
+// diameter of their ends. Pumps are sized so that all of them deliver 125% of the mean demand.
+
+#include "CLI/Console.h"
+
+#include "Core/project.h"
+#include "Core/network.h"
+#include "Elements/node.h"
+#include "epanet3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using Epanet::Project;
+
+/**
+ * @brief Command line of the generator
+ */
+class GenConfig
+{
+public:
+  GenConfig(int argc, char *argv[])
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      std::string arg = argv[i];
+      if (i + 1 >= argc && arg != "--no_check") throw std::runtime_error("gen: missing value of '" + arg + "'");
+      if (arg == "-t" || arg == "--topology")
+        topology = argv[++i];
+      else if (arg == "-n" || arg == "--nodes")
+        num_nodes = std::stoi(argv[++i]);
+      else if (arg == "-k" || arg == "--tanks")
+        num_tanks = std::stoi(argv[++i]);
+      else if (arg == "-m" || arg == "--stations")
+        num_stations = std::stoi(argv[++i]);
+      else if (arg == "--pumps")
+        pumps_per_station = std::stoi(argv[++i]);
+      else if (arg == "--dmas")
+        num_dmas = std::stoi(argv[++i]);
+      else if (arg == "--loops")
+        loops = std::stod(argv[++i]);
+      else if (arg == "--length")
+        length = std::stod(argv[++i]);
+      else if (arg == "--length_cv")
+        length_cv = std::stod(argv[++i]);
+      else if (arg == "--diameter_min")
+        diameter_min = std::stod(argv[++i]);
+      else if (arg == "--diameter_cv")
+        diameter_cv = std::stod(argv[++i]);
+      else if (arg == "--velocity")
+        velocity = std::stod(argv[++i]);
+      else if (arg == "--demand")
+        demand = std::stod(argv[++i]);
+      else if (arg == "--patterns")
+        num_patterns = std::stoi(argv[++i]);
+      else if (arg == "--elevation")
+        elevation = std::stod(argv[++i]);
+      else if (arg == "--head")
+        head = std::stod(argv[++i]);
+      else if (arg == "--pressure_min")
+        pressure_min = std::stod(argv[++i]);
+      else if (arg == "--seed")
+        seed = std::stoul(argv[++i]);
+      else if (arg == "-o" || arg == "--output")
+        output = argv[++i];
+      else if (arg == "--no_check")
+        check = false;
+      else
+        throw std::runtime_error("gen: unknown argument '" + arg + "'");
+    }
+
+    if (topology != "grid" && topology != "tree" && topology != "dma")
+      throw std::runtime_error("gen: topology must be grid, tree or dma");
+    if (num_nodes < 2) throw std::runtime_error("gen: at least 2 nodes are needed");
+    if (num_stations < 1 || pumps_per_station < 1) throw std::runtime_error("gen: at least one pump station with one pump is needed");
+    if (num_tanks < 0 || num_stations + num_tanks > num_nodes) throw std::runtime_error("gen: too many tanks and stations for the nodes");
+    if (num_dmas <= 0) num_dmas = std::max(1, (int)std::lround(num_nodes / 250.0));
+    num_dmas = std::min(num_dmas, num_nodes);
+    num_patterns = std::max(1, num_patterns);
+    loops = std::clamp(loops, 0.0, 1.0);
+  }
+
+  std::string topology = "grid";
+  int num_nodes = 1000;         // junctions
+  int num_tanks = 1;            // tanks
+  int num_stations = 1;         // pump stations (one reservoir each)
+  int pumps_per_station = 3;    // identical pumps in parallel in each station
+  int num_dmas = 0;             // district meter areas of the dma topology (0: one per 250 nodes)
+  double loops = 0.05;          // fraction of the non-tree lattice edges kept by tree and dma
+  double length = 100.0;        // mean pipe length (m)
+  double length_cv = 0.3;       // coefficient of variation of the pipe lengths
+  double diameter_min = 100.0;  // smallest pipe diameter (mm)
+  double diameter_cv = 0.2;     // lognormal scatter of the diameters around their sized value
+  double velocity = 0.5;        // design velocity of the pipe sizing (m/s)
+  double demand = 1.0;          // mean base demand of a junction (m3/h)
+  int num_patterns = 4;         // demand patterns (shifted copies of any-town's DEM)
+  double elevation = 20.0;      // elevation range of the junctions (m)
+  double head = 60.0;           // pump head at the design flow (m)
+  double pressure_min = 15.0;   // minimum pressure of the critical nodes in the spec (m)
+  unsigned long seed = 1;
+  std::string output = "network.inp"; // the constraint spec goes next to it with a .json extension
+  bool check = true;                  // load the written file and solve its first hydraulic step
+};
+
+/**
+ * @brief Synthetic network: lattice geometry, pipes, sources and patterns
+ */
+class Generator
+{
+public:
+  explicit Generator(const GenConfig &config) : config(config), rng(config.seed)
+  {
+  }
+
+  void build()
+  {
+    const int n = config.num_nodes;
+    x.resize(n);
+    y.resize(n);
+    elev.resize(n);
+    base_demand.resize(n);
+    pattern.resize(n);
+
+    if (config.topology == "dma")
+      build_dmas();
+    else
+      build_lattice(0, n, 0.0, 0.0, config.topology == "tree");
+
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> pick_pattern(0, config.num_patterns - 1);
+    const double x_max = std::max(1.0, *std::max_element(x.begin(), x.end()));
+    const double y_max = std::max(1.0, *std::max_element(y.begin(), y.end()));
+    for (int i = 0; i < n; ++i)
+    {
+      elev[i] = config.elevation * (0.45 * x[i] / x_max + 0.45 * y[i] / y_max + 0.1 * unit(rng));
+      base_demand[i] = config.demand * (0.5 + unit(rng));
+      pattern[i] = pick_pattern(rng);
+    }
+
+    build_patterns();
+    place_sources();
+    size_pipes();
+  }
+
+  void write_inp(const std::string &fn) const;
+  void write_spec(const std::string &fn) const;
+
+  int num_pipes() const
+  {
+    return (int)pipes.size();
+  }
+
+private:
+  struct Pipe
+  {
+    int n1, n2;      ///< junction indices (n2 >= num_nodes: tank n2 - num_nodes)
+    double length;   ///< m
+    double diameter; ///< mm
+  };
+
+  // Lattice of count junctions starting at index first; tree keeps a random spanning tree plus loops
+  void build_lattice(int first, int count, double x0, double y0, bool tree)
+  {
+    const int w = (int)std::ceil(std::sqrt((double)count));
+    for (int i = 0; i < count; ++i)
+    {
+      x[first + i] = x0 + (i % w) * config.length;
+      y[first + i] = y0 + (i / w) * config.length;
+    }
+
+    std::vector<std::pair<int, int>> edges;
+    for (int i = 0; i < count; ++i)
+    {
+      if (i % w + 1 < w && i + 1 < count) edges.emplace_back(first + i, first + i + 1);
+      if (i + w < count) edges.emplace_back(first + i, first + i + w);
+    }
+    if (!tree)
+    {
+      for (auto &e : edges) add_pipe(e.first, e.second, sample_length());
+      return;
+    }
+
+    // random spanning tree (Kruskal on shuffled edges), the rejected edges become loops
+    std::shuffle(edges.begin(), edges.end(), rng);
+    std::vector<int> root(count);
+    std::iota(root.begin(), root.end(), 0);
+    auto find = [&](int i)
+    {
+      while (root[i] != i) i = root[i] = root[root[i]];
+      return i;
+    };
+    std::bernoulli_distribution keep_loop(config.loops);
+    for (auto &e : edges)
+    {
+      const int a = find(e.first - first), b = find(e.second - first);
+      if (a != b)
+        root[a] = b;
+      else if (!keep_loop(rng))
+        continue;
+      add_pipe(e.first, e.second, sample_length());
+    }
+  }
+
+  // District meter areas on a coarse lattice, joined by a looped trunk main between their inlets
+  void build_dmas()
+  {
+    const int n = config.num_nodes, d = config.num_dmas;
+    const int w = (int)std::ceil(std::sqrt((double)d));
+    const double side = std::ceil(std::sqrt(std::ceil((double)n / d))) * config.length;
+    std::vector<int> inlet(d);
+    for (int k = 0; k < d; ++k)
+    {
+      const int first = (int)((long long)n * k / d), last = (int)((long long)n * (k + 1) / d);
+      build_lattice(first, last - first, (k % w) * (side + config.length), (k / w) * (side + config.length), true);
+      inlet[k] = first;
+    }
+    const double trunk = side + config.length;
+    for (int k = 0; k < d; ++k)
+    {
+      if (k % w + 1 < w && k + 1 < d) add_pipe(inlet[k], inlet[k + 1], trunk);
+      if (k + w < d) add_pipe(inlet[k], inlet[k + w], trunk);
+    }
+  }
+
+  void add_pipe(int n1, int n2, double length)
+  {
+    pipes.push_back({n1, n2, length, 0.0});
+  }
+
+  double sample_length()
+  {
+    const double s2 = std::log(1.0 + config.length_cv * config.length_cv);
+    std::lognormal_distribution<double> dist(std::log(config.length) - 0.5 * s2, std::sqrt(s2));
+    return std::max(1.0, dist(rng));
+  }
+
+  // Demand patterns: any-town's DEM shifted by up to two hours and scaled by up to 10%
+  void build_patterns()
+  {
+    static const double dem[24] = {0.7, 0.7, 0.7, 0.6, 0.6, 0.6, 1.2, 1.2, 1.2, 1.3, 1.3, 1.3,
+                                   1.2, 1.2, 1.2, 1.0, 1.0, 1.0, 0.9, 0.9, 0.9, 0.7, 0.7, 0.7};
+    std::uniform_int_distribution<int> shift(-2, 2);
+    std::uniform_real_distribution<double> scale(0.9, 1.1);
+    patterns.assign(config.num_patterns, std::vector<double>(24));
+    for (int p = 0; p < config.num_patterns; ++p)
+    {
+      const int s = p == 0 ? 0 : shift(rng);
+      const double f = p == 0 ? 1.0 : scale(rng);
+      for (int t = 0; t < 24; ++t) patterns[p][t] = f * dem[(t + s + 24) % 24];
+    }
+  }
+
+  // Pump stations and tanks at random junctions of consecutive index ranges (spread over the lattice)
+  void place_sources()
+  {
+    const int n = config.num_nodes, s = config.num_stations + config.num_tanks;
+    std::vector<int> slots(s);
+    for (int k = 0; k < s; ++k)
+    {
+      const int first = (int)((long long)n * k / s), last = (int)((long long)n * (k + 1) / s);
+      slots[k] = std::uniform_int_distribution<int>(first, last - 1)(rng);
+    }
+    std::shuffle(slots.begin(), slots.end(), rng);
+    station_node.assign(slots.begin(), slots.begin() + config.num_stations);
+    tank_node.assign(slots.begin() + config.num_stations, slots.end());
+
+    // tanks hold four hours of their share of the mean demand over their level range
+    const double total = std::accumulate(base_demand.begin(), base_demand.end(), 0.0);
+    const double share = total / std::max(1, config.num_tanks);
+    const double area = 4.0 * share / (0.2 * config.head);
+    tank_diameter = std::sqrt(4.0 * area / M_PI);
+    pump_flow = 1.25 * total / (config.num_stations * config.pumps_per_station);
+  }
+
+  // Pipes are sized for the peak demand supplied by the pump stations alone and by the tanks alone:
+  // the pipes of a breadth-first tree from the sources carry the demand below them
+  void size_pipes()
+  {
+    const int n = config.num_nodes, num_tanks = config.num_tanks;
+    std::vector<int> offset(n + 1, 0), adj(2 * pipes.size());
+    for (auto &p : pipes)
+    {
+      ++offset[p.n1 + 1];
+      ++offset[p.n2 + 1];
+    }
+    std::partial_sum(offset.begin(), offset.end(), offset.begin());
+    std::vector<int> fill(offset.begin(), offset.end() - 1);
+    for (int k = 0; k < (int)pipes.size(); ++k)
+    {
+      adj[fill[pipes[k].n1]++] = k;
+      adj[fill[pipes[k].n2]++] = k;
+    }
+
+    const double peak = 1.3;
+    std::vector<double> design(pipes.size(), 0.0); // design flow of each tree pipe (m3/h)
+    std::vector<double> supplied;                  // demand supplied by each tank in the tank pass
+    auto grow = [&](const std::vector<int> &roots)
+    {
+      std::vector<int> parent(n, -2), order; // parent pipe (-1: source, -2: not reached)
+      order.reserve(n);
+      for (int i : roots)
+        if (parent[i] == -2) parent[i] = -1, order.push_back(i);
+      for (size_t q = 0; q < order.size(); ++q)
+      {
+        const int i = order[q];
+        for (int a = offset[i]; a < offset[i + 1]; ++a)
+        {
+          const Pipe &p = pipes[adj[a]];
+          const int j = p.n1 == i ? p.n2 : p.n1;
+          if (parent[j] != -2) continue;
+          parent[j] = adj[a];
+          order.push_back(j);
+        }
+      }
+      if ((int)order.size() != n) throw std::runtime_error("gen: the network is not connected");
+
+      std::vector<double> flow(base_demand);
+      for (int q = n - 1; q >= 0; --q)
+      {
+        const int i = order[q];
+        if (parent[i] < 0) continue;
+        const Pipe &p = pipes[parent[i]];
+        design[parent[i]] = std::max(design[parent[i]], peak * flow[i]);
+        flow[p.n1 == i ? p.n2 : p.n1] += flow[i];
+      }
+      return flow;
+    };
+    grow(station_node);
+    if (num_tanks > 0) supplied = grow(tank_node);
+
+    // loop pipes take the smaller diameter of their ends
+    std::vector<double> d_node(n, std::numeric_limits<double>::max());
+    for (size_t k = 0; k < pipes.size(); ++k)
+    {
+      Pipe &p = pipes[k];
+      if (design[k] == 0.0) continue;
+      p.diameter = size(design[k]);
+      d_node[p.n1] = std::min(d_node[p.n1], p.diameter);
+      d_node[p.n2] = std::min(d_node[p.n2], p.diameter);
+    }
+    for (auto &p : pipes)
+      if (p.diameter == 0.0) p.diameter = std::max(config.diameter_min, std::min(d_node[p.n1], d_node[p.n2]));
+
+    // tank risers carry the demand of their tree
+    for (int k = 0; k < num_tanks; ++k)
+    {
+      const int i = tank_node[k];
+      pipes.push_back({i, n + k, config.length, size(peak * supplied[i])});
+    }
+  }
+
+  // Diameter (mm) for a flow (m3/h) at the design velocity, scattered and rounded up to a commercial size
+  double size(double flow)
+  {
+    static const double sizes[] = {80, 100, 150, 200, 250, 300, 350, 400, 450, 500, 600, 700, 800, 900, 1000, 1200, 1400, 1600, 1800, 2000};
+    const double s2 = std::log(1.0 + config.diameter_cv * config.diameter_cv);
+    std::lognormal_distribution<double> scatter(-0.5 * s2, std::sqrt(s2));
+    const double d = 1000.0 * std::sqrt(4.0 * flow / 3600.0 / (M_PI * config.velocity)) * scatter(rng);
+    for (double s : sizes)
+      if (s >= d && s >= config.diameter_min) return s;
+    return std::max(config.diameter_min, 200.0 * std::ceil(d / 200.0));
+  }
+
+  const GenConfig &config;
+  std::mt19937_64 rng;
+
+  std::vector<double> x, y;           ///< junction coordinates (m)
+  std::vector<double> elev;           ///< junction elevations (m)
+  std::vector<double> base_demand;    ///< junction base demands (m3/h)
+  std::vector<int> pattern;           ///< demand pattern of each junction
+  std::vector<Pipe> pipes;
+  std::vector<std::vector<double>> patterns; ///< 24 hourly multipliers of each demand pattern
+  std::vector<int> station_node;      ///< junction fed by each pump station
+  std::vector<int> tank_node;         ///< junction of each tank riser
+  double tank_diameter = 0.0;         ///< m
+  double pump_flow = 0.0;             ///< design flow of one pump (m3/h)
+};
+
+// Writes a pattern in lines of 6 multipliers
+static void write_pattern(FILE *f, const std::string &id, const std::vector<double> &v)
+{
+  for (size_t t = 0; t < v.size(); ++t)
+    std::fprintf(f, "%s%g%s", t % 6 == 0 ? (" " + id + "\t").c_str() : "", v[t], t % 6 == 5 || t + 1 == v.size() ? "\n" : "\t");
+}
+
+void Generator::write_inp(const std::string &fn) const
+{
+  std::unique_ptr<FILE, int (*)(FILE *)> file(std::fopen(fn.c_str(), "w"), std::fclose);
+  if (!file) throw std::runtime_error("gen: cannot write " + fn);
+  FILE *f = file.get();
+  const int n = config.num_nodes, num_tanks = config.num_tanks, m = config.num_stations, p = config.pumps_per_station;
+  const double h = config.head;
+
+  std::fprintf(f, "[TITLE]\nSynthetic %s network: %d junctions, %d tanks, %d pump stations of %d pumps (seed %lu)\n\n",
+               config.topology.c_str(), n, num_tanks, m, p, config.seed);
+
+  std::fprintf(f, "[JUNCTIONS]\n;ID\tElev\tDemand\tPattern\n");
+  for (int i = 0; i < n; ++i) std::fprintf(f, " J%d\t%.3f\t%.5f\tDEM%d\n", i + 1, elev[i], base_demand[i], pattern[i] + 1);
+
+  std::fprintf(f, "\n[RESERVOIRS]\n;ID\tHead\tPattern\n");
+  for (int s = 0; s < m; ++s) std::fprintf(f, " R%d\t0\n", s + 1);
+
+  std::fprintf(f, "\n[TANKS]\n;ID\tElevation\tInitLevel\tMinLevel\tMaxLevel\tDiameter\tMinVol\n");
+  for (int k = 0; k < num_tanks; ++k)
+    std::fprintf(f, " T%d\t0\t%.3f\t%.3f\t%.3f\t%.3f\t0\n", k + 1, 0.8 * h, 0.7 * h, 0.9 * h, tank_diameter);
+
+  std::fprintf(f, "\n[PIPES]\n;ID\tNode1\tNode2\tLength\tDiameter\tRoughness\tMinorLoss\tStatus\n");
+  for (size_t k = 0; k < pipes.size(); ++k)
+  {
+    const Pipe &q = pipes[k];
+    const std::string n2 = q.n2 < n ? "J" + std::to_string(q.n2 + 1) : "T" + std::to_string(q.n2 - n + 1);
+    std::fprintf(f, " P%zu\tJ%d\t%s\t%.2f\t%g\t120\t0\tOpen\n", k + 1, q.n1 + 1, n2.c_str(), q.length, q.diameter);
+  }
+
+  std::fprintf(f, "\n[PUMPS]\n;ID\tNode1\tNode2\tParameters\n");
+  for (int s = 0; s < m; ++s)
+    for (int j = 0; j < p; ++j)
+      std::fprintf(f, " PU%d_%d\tR%d\tJ%d\tHEAD 1\tPATTERN PMP%d_%d\n", s + 1, j + 1, s + 1, station_node[s] + 1, s + 1, j + 1);
+
+  // demand patterns, pump schedules (as many pumps on as the demand of the hour needs) and prices
+  std::fprintf(f, "\n[PATTERNS]\n;ID\tMultipliers\n");
+  for (int q = 0; q < (int)patterns.size(); ++q) write_pattern(f, "DEM" + std::to_string(q + 1), patterns[q]);
+  for (int s = 0; s < m; ++s)
+    for (int j = 0; j < p; ++j)
+    {
+      std::vector<double> on(24);
+      for (int t = 0; t < 24; ++t) on[t] = j < std::max(1L, std::lround(p * patterns[0][t] / 1.3)) ? 1.0 : 0.0;
+      write_pattern(f, "PMP" + std::to_string(s + 1) + "_" + std::to_string(j + 1), on);
+    }
+  write_pattern(f, "PRICES", {18.14, 18.14, 18.14, 18.14, 18.14, 18.14, 18.14, 35.28, 35.28, 35.28, 35.28, 35.28,
+                              35.28, 35.28, 35.28, 35.28, 35.28, 80.97, 80.97, 80.97, 80.97, 18.14, 18.14, 18.14});
+
+  // pump curve through (0, 4/3 h), (q, h), (2q, 0); efficiency peaks at the design flow
+  const double q = pump_flow;
+  std::fprintf(f, "\n[CURVES]\n;ID\tX-Value\tY-Value\n");
+  std::fprintf(f, " 1\t0\t%.4f\n 1\t%.4f\t%.4f\n 1\t%.4f\t0\n", 4.0 / 3.0 * h, q, h, 2.0 * q);
+  std::fprintf(f, " 2\t0\t0\n 2\t%.4f\t50\n 2\t%.4f\t75\n 2\t%.4f\t65\n 2\t%.4f\t40\n", 0.5 * q, q, 1.5 * q, 2.0 * q);
+
+  std::fprintf(f, "\n[ENERGY]\n Global Efficiency\t75\n Global Price\t0\n Demand Charge\t0\n");
+  for (int s = 0; s < m; ++s)
+    for (int j = 0; j < p; ++j)
+      std::fprintf(f, " Pump\tPU%d_%d\tEfficiency\t2\n Pump\tPU%d_%d\tPrice\t1\n Pump\tPU%d_%d\tPattern\tPRICES\n", s + 1, j + 1, s + 1,
+                   j + 1, s + 1, j + 1);
+
+  std::fprintf(f, "\n[TIMES]\n Duration\t24:00\n Hydraulic Timestep\t0:30\n Quality Timestep\t0:05\n Pattern Timestep\t1:00\n"
+                  " Pattern Start\t0:00\n Report Timestep\t1:00\n Report Start\t0:00\n Start ClockTime\t0:00\n Statistic\tNONE\n");
+  std::fprintf(f, "\n[REPORT]\n Status\tNo\n Summary\tNo\n Page\t0\n");
+  std::fprintf(f, "\n[OPTIONS]\n Units\tCMH\n Headloss\tH-W\n Specific Gravity\t1\n Viscosity\t1\n Trials\t40\n Accuracy\t0.01\n"
+                  " CHECKFREQ\t2\n MAXCHECK\t10\n DAMPLIMIT\t0\n Unbalanced\tContinue 10\n Pattern\tDEM1\n Demand Multiplier\t1\n"
+                  " Emitter Exponent\t2\n Quality\tNone mg/L\n");
+
+  std::fprintf(f, "\n[COORDINATES]\n;Node\tX-Coord\tY-Coord\n");
+  for (int i = 0; i < n; ++i) std::fprintf(f, " J%d\t%.2f\t%.2f\n", i + 1, x[i], y[i]);
+
+  std::fprintf(f, "\n[END]\n");
+  if (std::ferror(f)) throw std::runtime_error("gen: error writing " + fn);
+}
+
+void Generator::write_spec(const std::string &fn) const
+{
+  nlohmann::json j;
+
+  // critical nodes: the three highest junctions
+  std::vector<int> nodes(config.num_nodes);
+  std::iota(nodes.begin(), nodes.end(), 0);
+  const int num_critical = std::min(3, config.num_nodes);
+  std::partial_sort(nodes.begin(), nodes.begin() + num_critical, nodes.end(), [&](int a, int b) { return elev[a] > elev[b]; });
+  j["nodes"] = nlohmann::json::array();
+  for (int k = 0; k < num_critical; ++k)
+    j["nodes"].push_back({{"id", "J" + std::to_string(nodes[k] + 1)}, {"pressure_min", config.pressure_min}});
+
+  const double h = config.head;
+  j["tanks"] = nlohmann::json::array();
+  for (int k = 0; k < config.num_tanks; ++k)
+    j["tanks"].push_back({{"id", "T" + std::to_string(k + 1)}, {"level_min", 0.7 * h}, {"level_max", 0.9 * h}, {"level_final", 0.8 * h}});
+
+  std::vector<std::string> pumps;
+  for (int s = 0; s < config.num_stations; ++s)
+    for (int p = 0; p < config.pumps_per_station; ++p) pumps.push_back("PU" + std::to_string(s + 1) + "_" + std::to_string(p + 1));
+  j["pumps"] = pumps;
+  j["cost"]["pumps"] = pumps;
+
+  std::ofstream f(fn);
+  f << j.dump(2) << "\n";
+  if (!f) throw std::runtime_error("gen: error writing " + fn);
+}
+
+// Loads the written network through the input reader and solves its first hydraulic step
+static void check_network(const std::string &inp)
+{
+  Project p;
+  CHK(p.load(inp.c_str()), "gen: Load " + inp);
+  CHK(p.initSolver(EN_INITFLOW), "gen: Init solver");
+  int t = 0;
+  CHK(p.runSolver(&t), "gen: Run solver");
+
+  Network *nw = p.getNetwork();
+  Node *low = nullptr;
+  for (Node *node : nw->nodes)
+    if (node->type() == Node::JUNCTION && (!low || node->head - node->elev < low->head - low->elev)) low = node;
+  Console::printf(Console::Color::BRIGHT_GREEN, "✅ %s loads and solves: %d nodes, %d links, lowest pressure %.2f at %s\n", inp.c_str(),
+                  nw->count(Element::NODE), nw->count(Element::LINK), (low->head - low->elev) * nw->ucf(Units::PRESSURE),
+                  low->name.c_str());
+}
+
+int main(int argc, char *argv[])
+{
+  try
+  {
+    GenConfig config(argc, argv);
+    Generator gen(config);
+    gen.build();
+
+    const std::string spec = config.output.substr(0, config.output.find_last_of('.')) + ".json";
+    gen.write_inp(config.output);
+    gen.write_spec(spec);
+    Console::printf(Console::Color::BRIGHT_YELLOW, "💾 Writing %s network to files: %s, %s (%d junctions, %d pipes)\n",
+                    config.topology.c_str(), config.output.c_str(), spec.c_str(), config.num_nodes, gen.num_pipes());
+
+    if (config.check) check_network(config.output);
+  }
+  catch (const std::exception &e)
+  {
+    Console::printf(Console::Color::BRIGHT_RED, "Error: %s\n", e.what());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
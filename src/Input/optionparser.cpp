@@ -29,6 +29,7 @@ static const char *stringOptionKeywords[] = {"HYDRAULICS_FILE",
                                              "HYDRAULIC_SOLVER",
                                              "STEP_SIZING",
                                              "MATRIX_SOLVER",
+                                             "MATRIX_ORDERING",
                                              "",
                                              "QUALITY_MODEL",
                                              "QUALITY_NAME",
@@ -15,6 +15,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 using namespace std;
 
 //-----------------------------------------------------------------------------
@@ -37,8 +38,71 @@ const double AC = -5.14214965799e-03; // AA*AB
 
 //-----------------------------------------------------------------------------
 
-// Darcy-Weisbach friction factor
-double frictionFactor(double q, double e, double s, double &dfdq);
+//-----------------------------------------------------------------------------
+//  Vectorizable elementary functions for the batched head loss methods
+//  (branch free, so that the loops over pipes compile to SIMD code)
+//-----------------------------------------------------------------------------
+
+// Natural log of |x| (relative error < 1e-15 for normal x; ln(0) ~ -709.1)
+
+static inline double fastLog(double x) {
+  // ... split |x| into 2^e * m with m in [sqrt(1/2), sqrt(2))
+  int64_t bits = __builtin_bit_cast(int64_t, x) & 0x7FFFFFFFFFFFFFFFLL;
+  double e = (double)((bits >> 52) - 1023);
+  double m = __builtin_bit_cast(double, (bits & 0x000FFFFFFFFFFFFFLL) |
+                                            0x3FF0000000000000LL);
+  bool high = m > 1.4142135623730951;
+  m = high ? 0.5 * m : m;
+  e = high ? e + 1.0 : e;
+
+  // ... ln(m) = 2 atanh(z) with z = (m-1)/(m+1), |z| < 0.172
+  double z = (m - 1.0) / (m + 1.0);
+  double z2 = z * z;
+  double p = 1.0 / 21.0;
+  p = p * z2 + 1.0 / 19.0;
+  p = p * z2 + 1.0 / 17.0;
+  p = p * z2 + 1.0 / 15.0;
+  p = p * z2 + 1.0 / 13.0;
+  p = p * z2 + 1.0 / 11.0;
+  p = p * z2 + 1.0 / 9.0;
+  p = p * z2 + 1.0 / 7.0;
+  p = p * z2 + 1.0 / 5.0;
+  p = p * z2 + 1.0 / 3.0;
+  p = p * z2 + 1.0;
+  return e * 0.6931471805599453 + 2.0 * z * p;
+}
+
+// Exponential of x for |x| < 708 (relative error < 1e-15)
+
+static inline double fastExp(double x) {
+  // ... x = n ln(2) + t with n integer and |t| <= ln(2)/2
+  const double round = 6755399441055744.0; // 1.5 * 2^52
+  double n = (x * 1.4426950408889634 + round) - round;
+  double t = (x - n * 0.6931471805599453) - n * 2.3190468138462996e-17;
+
+  // ... Taylor series of exp(t) to degree 13, times 2^n
+  double p = 1.0 / 6227020800.0;
+  p = p * t + 1.0 / 479001600.0;
+  p = p * t + 1.0 / 39916800.0;
+  p = p * t + 1.0 / 3628800.0;
+  p = p * t + 1.0 / 362880.0;
+  p = p * t + 1.0 / 40320.0;
+  p = p * t + 1.0 / 5040.0;
+  p = p * t + 1.0 / 720.0;
+  p = p * t + 1.0 / 120.0;
+  p = p * t + 1.0 / 24.0;
+  p = p * t + 1.0 / 6.0;
+  p = p * t + 0.5;
+  p = p * t + 1.0;
+  p = p * t + 1.0;
+  return p * __builtin_bit_cast(double, ((int64_t)n + 1023) << 52);
+}
+
+// |x| raised to the power a (relative error < 1e-14 for moderate results)
+
+static inline double fastPow(double x, double a) {
+  return fastExp(a * fastLog(x));
+}
 
 //-----------------------------------------------------------------------------
 
@@ -50,6 +114,15 @@ HeadLossModel::HeadLossModel(double viscos) : viscosity(viscos) {}
 
 HeadLossModel::~HeadLossModel() {}
 
+// Head loss of a single pipe (a batch of one)
+
+void HeadLossModel::findHeadLoss(Pipe *pipe, double flow, double &headLoss,
+                                 double &gradient) {
+  PipeBatch pipes = {1, &pipe->resistance, &pipe->lossFactor, &pipe->diameter,
+                     &pipe->roughness};
+  findHeadLosses(pipes, &flow, &headLoss, &gradient);
+}
+
 //-----------------------------------------------------------------------------
 // Head loss model factory
 //-----------------------------------------------------------------------------
@@ -94,27 +167,34 @@ void HW_HeadLossModel::setResistance(Pipe *pipe) {
   pipe->resistance = min(pipe->resistance, HIGH_RESISTANCE);
 }
 
-void HW_HeadLossModel::findHeadLoss(Pipe *pipe, double flow, double &headLoss,
-                                    double &gradient) {
-  double q = abs(flow);
-  double r = pipe->resistance;
-  double k = pipe->lossFactor;
-
-  gradient = HW_EXP * r * pow(q, HW_EXP - 1.0);
-  if (gradient < MIN_GRADIENT) {
-    gradient = MIN_GRADIENT;
-    headLoss = q * gradient;
-  } else
-    headLoss = q * gradient / HW_EXP;
-  if (k > 0.0) {
-    headLoss += k * q * q;
-    gradient += 2.0 * k * q;
-  }
+void HW_HeadLossModel::findHeadLosses(const PipeBatch &pipes,
+                                      const double flow[], double headLoss[],
+                                      double gradient[]) {
+  const double *res = pipes.resistance;
+  const double *loss = pipes.lossFactor;
+
+#pragma omp simd
+  for (int i = 0; i < pipes.count; i++) {
+    double q = abs(flow[i]);
+    double r = res[i];
+    double k = loss[i];
+
+    double g = HW_EXP * r * fastPow(q, HW_EXP - 1.0);
+    bool low = g < MIN_GRADIENT;
+    g = low ? MIN_GRADIENT : g;
+    double h = low ? q * g : q * g / HW_EXP;
+
+    // ... minor losses
+
+    bool minor = k > 0.0;
+    h = minor ? h + k * q * q : h;
+    g = minor ? g + 2.0 * k * q : g;
 
-  // ... give proper sign to head loss
+    // ... give proper sign to head loss
 
-  if (flow < 0.0)
-    headLoss = -headLoss;
+    headLoss[i] = (flow[i] < 0.0) ? -h : h;
+    gradient[i] = g;
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -130,21 +210,28 @@ void CM_HeadLossModel::setResistance(Pipe *pipe) {
   pipe->resistance = min(pipe->resistance, HIGH_RESISTANCE);
 }
 
-void CM_HeadLossModel::findHeadLoss(Pipe *pipe, double flow, double &headLoss,
-                                    double &gradient) {
-  double q = abs(flow);
-  double r = pipe->resistance;
-  double k = pipe->lossFactor;
-
-  gradient = 2.0 * r * q;
-  if (gradient < MIN_GRADIENT) {
-    gradient = MIN_GRADIENT;
-    headLoss = q * gradient;
-  } else
-    headLoss = q * gradient / 2.0;
-  if (k > 0.0) {
-    headLoss += k * q * q;
-    gradient += 2.0 * k * q;
+void CM_HeadLossModel::findHeadLosses(const PipeBatch &pipes,
+                                      const double flow[], double headLoss[],
+                                      double gradient[]) {
+  const double *res = pipes.resistance;
+  const double *loss = pipes.lossFactor;
+
+#pragma omp simd
+  for (int i = 0; i < pipes.count; i++) {
+    double q = abs(flow[i]);
+    double r = res[i];
+    double k = loss[i];
+
+    double g = 2.0 * r * q;
+    bool low = g < MIN_GRADIENT;
+    g = low ? MIN_GRADIENT : g;
+    double h = low ? q * g : q * g / 2.0;
+
+    // ... minor losses
+
+    bool minor = k > 0.0;
+    headLoss[i] = minor ? h + k * q * q : h;
+    gradient[i] = minor ? g + 2.0 * k * q : g;
   }
 }
 
@@ -164,76 +251,65 @@ void DW_HeadLossModel::setResistance(Pipe *pipe) {
   pipe->resistance = min(pipe->resistance, HIGH_RESISTANCE);
 }
 
-void DW_HeadLossModel::findHeadLoss(Pipe *pipe, double flow, double &headLoss,
-                                    double &gradient) {
-  double q = abs(flow);
-  double r = pipe->resistance;
-  double k = pipe->lossFactor;
-  double s = viscosity * pipe->diameter;
+void DW_HeadLossModel::findHeadLosses(const PipeBatch &pipes,
+                                      const double flow[], double headLoss[],
+                                      double gradient[]) {
+  const double *res = pipes.resistance;
+  const double *loss = pipes.lossFactor;
+  const double *diam = pipes.diameter;
+  const double *rough = pipes.roughness;
 
-  // ... use Hagen-Poiseuille formula for laminar flow (Re <= 2000)
+#pragma omp simd
+  for (int i = 0; i < pipes.count; i++) {
+    double q = abs(flow[i]);
+    double r = res[i];
+    double k = loss[i];
+    double s = viscosity * diam[i];
+    double e = rough[i] / diam[i];
 
-  if (q <= A2 * s) {
-    r = 16.0 * PI * s * pipe->resistance;
-    headLoss = flow * (r + k * q);
-    gradient = r + 2.0 * k * q;
-  }
+    // ... Hagen-Poiseuille formula for laminar flow (Re <= 2000)
 
-  // ... use Colebrook formula for turbulent flow
+    bool laminar = q <= A2 * s;
+    double rl = 16.0 * PI * s * r;
+    double hLam = flow[i] * (rl + k * q);
+    double gLam = rl + 2.0 * k * q;
 
-  else {
-    double dfdq = 0.0;
-    double e = pipe->roughness / pipe->diameter;
-    double f = frictionFactor(q, e, s, dfdq);
-    double r1 = f * r + k;
-    headLoss = r1 * q * flow;
-    gradient = (2.0 * r1 * q) + (dfdq * r * q * q);
-  }
-}
+    // ... Darcy-Weisbach friction factor for turbulent flow
+    //     (laminar lanes are evaluated at Re = 4000 to stay finite)
 
-double frictionFactor(double q, double e, double s, double &dfdq)
-//
-//   Purpose: computes Darcy-Weisbach friction factor
-//   Input:   q = flow rate (cfs)
-//            e = roughness / diameter
-//            s = viscosity * diameter
-//   Output:  returns Darcy-Weisbach friction factor and its derivative dfdq
-//
-////////////////////////////////////////////////////////////
-//// Replace with more recently derived approximation.  ////
-////////////////////////////////////////////////////////////
-//   Uses interpolating polynomials developed by
-//   E. Dunlop for transition flow from 2000 < Re < 4000.
-//
-{
-  double f; // friction factor
-  double x1, x2, x3, x4, y1, y2, y3, fa, fb, r;
-  double w = q / s; // Re*Pi/4
-
-  // for Re >= 4000 use Colebrook Formula
-
-  if (w >= A1) {
-    y1 = A8 / pow(w, 0.9);
-    y2 = e / 3.7 + y1;
-    y3 = A9 * log(y2);
-    f = 1.0 / (y3 * y3);
-    dfdq = 1.8 * f * y1 * A9 / y2 / y3 / q;
-  }
+    double qt = laminar ? A1 * s : q;
+    double w = qt / s; // Re*Pi/4
 
-  // otherwise use interpolation formula
+    // ... Colebrook formula for Re >= 4000
+
+    double y1 = A8 * fastPow(w, -0.9);
+    double y2 = e / 3.7 + y1;
+    double y3 = A9 * fastLog(y2);
+    double fc = 1.0 / (y3 * y3);
+    double dfc = 1.8 * fc * y1 * A9 / y2 / y3 / qt;
+
+    // ... Dunlop's interpolation polynomial for 2000 < Re < 4000
 
-  else {
     y2 = e / 3.7 + AB;
-    y3 = A9 * log(y2);
-    fa = 1.0 / (y3 * y3);
-    fb = (2.0 + AC / (y2 * y3)) * fa;
-    r = w / A2;
-    x1 = 7.0 * fa - fb;
-    x2 = 0.128 - 17.0 * fa + 2.5 * fb;
-    x3 = -0.128 + 13.0 * fa - (fb + fb);
-    x4 = r * (0.032 - 3.0 * fa + 0.5 * fb);
-    f = x1 + r * (x2 + r * (x3 + x4));
-    dfdq = (x2 + 2.0 * r * (x3 + x4)) / s / A2;
+    y3 = A9 * fastLog(y2);
+    double fa = 1.0 / (y3 * y3);
+    double fb = (2.0 + AC / (y2 * y3)) * fa;
+    double rw = w / A2;
+    double x1 = 7.0 * fa - fb;
+    double x2 = 0.128 - 17.0 * fa + 2.5 * fb;
+    double x3 = -0.128 + 13.0 * fa - (fb + fb);
+    double x4 = rw * (0.032 - 3.0 * fa + 0.5 * fb);
+    double fi = x1 + rw * (x2 + rw * (x3 + x4));
+    double dfi = (x2 + 2.0 * rw * (x3 + x4)) / s / A2;
+
+    bool colebrook = w >= A1;
+    double f = colebrook ? fc : fi;
+    double dfdq = colebrook ? dfc : dfi;
+    double r1 = f * r + k;
+    double hTurb = r1 * q * flow[i];
+    double gTurb = (2.0 * r1 * q) + (dfdq * r * q * q);
+
+    headLoss[i] = laminar ? hLam : hTurb;
+    gradient[i] = laminar ? gLam : gTurb;
   }
-  return f;
 }
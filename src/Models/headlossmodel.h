@@ -18,6 +18,18 @@
 
 class Pipe;
 
+//! \struct PipeBatch
+//! \brief Contiguous parameters of a batch of open pipes without check
+//!        valves, for the batched head loss methods.
+
+struct PipeBatch {
+  int count;                //!< number of pipes
+  const double *resistance; //!< resistance factors (units depend on model)
+  const double *lossFactor; //!< minor loss factors (ft/cfs^2)
+  const double *diameter;   //!< diameters (ft)
+  const double *roughness;  //!< roughness parameters (units depend on model)
+};
+
 //! \class HeadLossModel
 //! \brief The interface for a pipe head loss model.
 //!
@@ -45,8 +57,13 @@ public:
   virtual void setResistance(Pipe *pipe) = 0;
 
   /// Method that finds a link's head loss and its gradient
-  virtual void findHeadLoss(Pipe *pipe, double flow, double &headLoss,
-                            double &gradient) = 0;
+  void findHeadLoss(Pipe *pipe, double flow, double &headLoss,
+                    double &gradient);
+
+  /// Method that finds the head losses and gradients of a batch of pipes
+  /// (vectorized; the branches of the formulas are applied as masks)
+  virtual void findHeadLosses(const PipeBatch &pipes, const double flow[],
+                              double headLoss[], double gradient[]) = 0;
 
   //! Serialize to JSON for HeadLossModel
   nlohmann::json to_json() const { return {{"viscosity", viscosity}}; }
@@ -69,8 +86,8 @@ class HW_HeadLossModel : public HeadLossModel {
 public:
   HW_HeadLossModel(double viscos);
   void setResistance(Pipe *pipe);
-  void findHeadLoss(Pipe *pipe, double flow, double &headLoss,
-                    double &gradient);
+  void findHeadLosses(const PipeBatch &pipes, const double flow[],
+                      double headLoss[], double gradient[]);
 };
 
 //-----------------------------------------------------------------------------
@@ -82,8 +99,8 @@ class DW_HeadLossModel : public HeadLossModel {
 public:
   DW_HeadLossModel(double viscos);
   void setResistance(Pipe *pipe);
-  void findHeadLoss(Pipe *pipe, double flow, double &headLoss,
-                    double &gradient);
+  void findHeadLosses(const PipeBatch &pipes, const double flow[],
+                      double headLoss[], double gradient[]);
 };
 
 //-----------------------------------------------------------------------------
@@ -95,8 +112,8 @@ class CM_HeadLossModel : public HeadLossModel {
 public:
   CM_HeadLossModel(double viscos);
   void setResistance(Pipe *pipe);
-  void findHeadLoss(Pipe *pipe, double flow, double &headLoss,
-                    double &gradient);
+  void findHeadLosses(const PipeBatch &pipes, const double flow[],
+                      double headLoss[], double gradient[]);
 };
 
 #endif
@@ -147,3 +147,30 @@ double PumpEnergy::findEfficiency(Pump *pump, Network *network) {
   }
   return effic;
 }
+
+//-----------------------------------------------------------------------------
+
+//  Finds an upper bound on the efficiency (%) returned by findEfficiency
+//  for any flow and for the speed settings of the pump's speed pattern.
+
+double PumpEnergy::findMaxEfficiency(Pump *pump, Network *network) {
+  if (!pump->efficCurve)
+    return network->option(Options::PUMP_EFFICIENCY);
+
+  // ... the curve's efficiency is largest at one of its data points
+
+  double effic = 1.0;
+  for (int i = 0; i < pump->efficCurve->size(); i++)
+    effic = max(effic, pump->efficCurve->y(i));
+
+  // ... the speed adjustment only raises the efficiency for speeds above 1
+
+  double maxSpeed = pump->speed;
+  if (pump->speedPattern) {
+    for (int i = 0; i < pump->speedPattern->size(); i++)
+      maxSpeed = max(maxSpeed, pump->speedPattern->factor(i));
+  }
+  if (maxSpeed > 1.0)
+    effic = 100.0 - ((100.0 - effic) * pow(1.0 / maxSpeed, 0.1));
+  return min(effic, 100.0);
+}
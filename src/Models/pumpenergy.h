@@ -40,6 +40,8 @@ public:
   void init();
   double updateEnergyUsage(Pump *pump, Network *network, int dt);
   double getCost() { return adjustedTotalCost; }
+  double findCostFactor(Pump *pump, Network *network);
+  double findMaxEfficiency(Pump *pump, Network *network);
 
   // Computed Properties
   double hrsOnLine;         //!< hours pump is online
@@ -93,7 +95,6 @@ public:
   }
 
 private:
-  double findCostFactor(Pump *pump, Network *network);
   double findEfficiency(Pump *pump, Network *network);
 };
 
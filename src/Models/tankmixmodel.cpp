@@ -26,6 +26,14 @@ TankMixModel::TankMixModel()
     : type(MIX1), cTol(0.0), fracMixed(0.0), cTank(0.0), vMixed(0.0),
       firstSeg(nullptr), lastSeg(nullptr) {}
 
+// The copy shares no volume segments with the original (they are re-created
+// by init() when a quality analysis starts).
+
+TankMixModel::TankMixModel(const TankMixModel &model)
+    : type(model.type), cTol(model.cTol), fracMixed(model.fracMixed),
+      cTank(model.cTank), vMixed(model.vMixed), firstSeg(nullptr),
+      lastSeg(nullptr) {}
+
 TankMixModel::~TankMixModel() {}
 
 //-----------------------------------------------------------------------------
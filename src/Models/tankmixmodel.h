@@ -35,6 +35,7 @@ public:
 
   // Constructor / Destructor
   TankMixModel();
+  TankMixModel(const TankMixModel &model);
   ~TankMixModel();
 
   // Methods
@@ -65,6 +65,7 @@ GGASolver::GGASolver(Network *nw, MatrixSolver *ms) : HydSolver(nw, ms) {
   dH.resize(nodeCount, 0); // nodal head changes
   dQ.resize(linkCount, 0); // link flow changes
   xQ.resize(nodeCount, 0); // nodal excess flow (inflow - outflow)
+  hydState.init(network);  // contiguous copy of heads and flows
 
   hLossEvalCount = 0;
   trialsLimit = 0;
@@ -125,6 +126,10 @@ int GGASolver::solve(double tstep_, int &trials) {
 
   setConvergenceLimits();
 
+  // ... iterate on the solver's copy of the network's heads and flows
+
+  hydState.gather(network);
+
   // ... perform Newton iterations
 
   while (trials <= trialsLimit) {
@@ -148,6 +153,7 @@ int GGASolver::solve(double tstep_, int &trials) {
 
     int errorCode = findHeadChanges();
     if (errorCode >= 0) {
+      hydState.scatter(network);
       Node *node = network->node(errorCode);
       network->msgLog << endl << s_IllConditioned << node->name;
       return HydSolver::FAILED_ILL_CONDITIONED;
@@ -180,6 +186,7 @@ int GGASolver::solve(double tstep_, int &trials) {
     trials++;
   }
   // if ( reportTrials ) network->msgLog << s_HlossEvals << hLossEvalCount;
+  hydState.scatter(network);
   if (trials > trialsLimit)
     return HydSolver::FAILED_NO_CONVERGENCE;
   return HydSolver::SUCCESSFUL;
@@ -228,36 +235,33 @@ void GGASolver::setConvergenceLimits() {
 //  Adjust fixed grade status of specific nodes.
 
 void GGASolver::setFixedGradeNodes() {
-  Node *node;
-
   // ... change fixed grade status for PRV/PSV nodes
 
-  for (Link *link : network->links) {
-    // ... check if link is a PRV or PSV
+  for (int j : hydState.valveLinks) {
+    // ... the control node is downstream of a PRV, upstream of a PSV
 
-    if (link->isPRV())
-      node = link->toNode;
-    else if (link->isPSV())
-      node = link->fromNode;
-    else
-      continue;
+    Link *link = network->link(j);
+    int i = (hydState.linkKind[j] == HydState::PRV) ? hydState.toNode[j]
+                                                     : hydState.fromNode[j];
+    Node *node = network->node(i);
 
     // ... set the fixed grade status of the valve's control node
 
     if (link->status == Link::VALVE_ACTIVE) {
       node->fixedGrade = true;
-      node->head = link->setting + node->elev;
+      hydState.head[i] = link->setting + node->elev;
     } else
       node->fixedGrade = false;
+    hydState.fixedGrade[i] = node->fixedGrade;
   }
 
   // ... after time 0, tstep will be non-zero and tank levels
   //     will be non-fixed if time weighting (theta) is non-zero
 
   if (theta > 0.0 && tstep > 0.0) {
-    for (Node *tankNode : network->nodes) {
-      if (tankNode->type() == Node::TANK)
-        tankNode->fixedGrade = false;
+    for (int i : hydState.tankNodes) {
+      network->node(i)->fixedGrade = false;
+      hydState.fixedGrade[i] = false;
     }
   }
 }
@@ -285,8 +289,9 @@ int GGASolver::findHeadChanges() {
 
   // ... save new heads as head changes
 
+  const double *head = hydState.head.data();
   for (int i = 0; i < nodeCount; i++) {
-    dH[i] = h[i] - network->node(i)->head;
+    dH[i] = h[i] - head[i];
   }
 
   // ... return a negative number indicating that
@@ -300,33 +305,41 @@ int GGASolver::findHeadChanges() {
 //  Find the changes in link flows resulting from a set of nodal head changes.
 
 void GGASolver::findFlowChanges() {
+  const int *fromNode = hydState.fromNode.data();
+  const int *toNode = hydState.toNode.data();
+  const char *linkKind = hydState.linkKind.data();
+  const double *flow = hydState.flow.data();
+  const double *hLoss = hydState.hLoss.data();
+  const double *hGrad = hydState.hGrad.data();
+  const double *head = hydState.head.data();
+
   for (int i = 0; i < linkCount; i++) {
-    // ... get link object and its end node indexes
+    // ... get link's end node indexes
 
     dQ[i] = 0.0;
-    Link *link = network->link(i);
-    int n1 = link->fromNode->index;
-    int n2 = link->toNode->index;
+    int n1 = fromNode[i];
+    int n2 = toNode[i];
 
     // ... flow change for pressure regulating valves
 
-    if (link->hGrad == 0.0) {
-      if (link->isPRV())
-        dQ[i] = -xQ[n2] - link->flow;
-      if (link->isPSV())
-        dQ[i] = xQ[n1] - link->flow;
+    if (hGrad[i] == 0.0) {
+      if (linkKind[i] == HydState::PRV)
+        dQ[i] = -xQ[n2] - flow[i];
+      if (linkKind[i] == HydState::PSV)
+        dQ[i] = xQ[n1] - flow[i];
       continue;
     }
 
     // ... apply GGA flow change formula:
 
-    double dh = (link->fromNode->head + dH[n1]) - (link->toNode->head + dH[n2]);
-    double dq = (link->hLoss - dh) / link->hGrad;
+    double dh = (head[n1] + dH[n1]) - (head[n2] + dH[n2]);
+    double dq = (hLoss[i] - dh) / hGrad[i];
 
     // ... special case to prevent negative flow in constant HP pumps
 
-    if (link->isHpPump() && link->status == Link::LINK_OPEN && dq > link->flow)
-      dq = link->flow / 2.0;
+    if (linkKind[i] == HydState::HP_PUMP && dq > flow[i] &&
+        network->link(i)->status == Link::LINK_OPEN)
+      dq = flow[i] / 2.0;
 
     // ... save flow change
 
@@ -371,7 +384,7 @@ double GGASolver::findStepSize(int trials) {
 double GGASolver::findErrorNorm(double lamda) {
   hLossEvalCount++;
   return hydBalance.evaluate(lamda, (double *)&dH[0], (double *)&dQ[0],
-                             (double *)&xQ[0], network);
+                             (double *)&xQ[0], hydState, network);
 }
 
 //-----------------------------------------------------------------------------
@@ -379,10 +392,12 @@ double GGASolver::findErrorNorm(double lamda) {
 //  Update heads and flows for a given step size.
 
 void GGASolver::updateSolution(double lamda) {
+  double *head = hydState.head.data();
+  double *flow = hydState.flow.data();
   for (int i = 0; i < nodeCount; i++)
-    network->node(i)->head += lamda * dH[i];
+    head[i] += lamda * dH[i];
   for (int i = 0; i < linkCount; i++)
-    network->link(i)->flow += lamda * dQ[i];
+    flow[i] += lamda * dQ[i];
 }
 
 //-----------------------------------------------------------------------------
@@ -458,44 +473,49 @@ void GGASolver::setMatrixCoeffs() {
 //  Compute matrix coefficients for link head loss gradients.
 
 void GGASolver::setLinkCoeffs() {
+  const int *fromNode = hydState.fromNode.data();
+  const int *toNode = hydState.toNode.data();
+  const double *flow = hydState.flow.data();
+  const double *hLoss = hydState.hLoss.data();
+  const double *hGrad = hydState.hGrad.data();
+  const double *head = hydState.head.data();
+  const char *fixedGrade = hydState.fixedGrade.data();
+
   for (int j = 0; j < linkCount; j++) {
     // ... skip links with zero head gradient
     //     (e.g. active pressure regulating valves)
 
-    Link *link = network->link(j);
-    if (link->hGrad == 0.0)
+    if (hGrad[j] == 0.0)
       continue;
 
     // ... identify end nodes of link
 
-    Node *node1 = link->fromNode;
-    Node *node2 = link->toNode;
-    int n1 = node1->index;
-    int n2 = node2->index;
+    int n1 = fromNode[j];
+    int n2 = toNode[j];
 
     // ... update node flow balances
 
-    xQ[n1] -= link->flow;
-    xQ[n2] += link->flow;
+    xQ[n1] -= flow[j];
+    xQ[n2] += flow[j];
 
     // ... a is contribution to coefficient matrix
     //     b is contribution to right hand side
 
-    double a = 1.0 / link->hGrad;
-    double b = a * link->hLoss;
+    double a = 1.0 / hGrad[j];
+    double b = a * hLoss[j];
 
     // ... update off-diagonal coeff. of matrix if both start and
     //     end nodes are not fixed grade
 
-    if (!node1->fixedGrade && !node2->fixedGrade) {
+    if (!fixedGrade[n1] && !fixedGrade[n2]) {
       matrixSolver->addToOffDiag(j, -a);
     }
 
     // ... if start node has fixed grade, then apply a to r.h.s.
     //     of that node's row;
 
-    if (node1->fixedGrade) {
-      matrixSolver->addToRhs(n2, a * node1->head);
+    if (fixedGrade[n1]) {
+      matrixSolver->addToRhs(n2, a * head[n1]);
     }
 
     // ... otherwise add a to row's diagonal coeff. and
@@ -508,8 +528,8 @@ void GGASolver::setLinkCoeffs() {
 
     // ... do the same for the end node, except subtract b from r.h.s
 
-    if (node2->fixedGrade) {
-      matrixSolver->addToRhs(n1, a * node2->head);
+    if (fixedGrade[n2]) {
+      matrixSolver->addToRhs(n1, a * head[n2]);
     } else {
       matrixSolver->addToDiag(n2, a);
       matrixSolver->addToRhs(n2, -b);
@@ -522,16 +542,21 @@ void GGASolver::setLinkCoeffs() {
 //  Compute matrix coefficients for dynamic tanks and external node outflows.
 
 void GGASolver::setNodeCoeffs() {
+  const char *nodeType = hydState.nodeType.data();
+  const char *fixedGrade = hydState.fixedGrade.data();
+  const double *head = hydState.head.data();
+  const double *outflow = hydState.outflow.data();
+  const double *qGrad = hydState.qGrad.data();
+
   for (int i = 0; i < nodeCount; i++) {
     // ... if node's head not fixed
 
-    Node *node = network->node(i);
-    if (!node->fixedGrade) {
+    if (!fixedGrade[i]) {
       // ... for dynamic tanks, add area terms to row i
       //     of the head solution matrix & r.h.s. vector
 
-      if (node->type() == Node::TANK && theta != 0.0) {
-        Tank *tank = static_cast<Tank *>(node);
+      if (nodeType[i] == Node::TANK && theta != 0.0) {
+        Tank *tank = static_cast<Tank *>(network->node(i));
         double a = tank->area / (theta * tstep);
         matrixSolver->addToDiag(i, a);
 
@@ -541,11 +566,11 @@ void GGASolver::setNodeCoeffs() {
 
       // ... for junctions, add effect of external outflows
 
-      else if (node->type() == Node::JUNCTION) {
+      else if (nodeType[i] == Node::JUNCTION) {
         // ... update junction's net inflow
-        xQ[i] -= node->outflow;
-        matrixSolver->addToDiag(i, node->qGrad);
-        matrixSolver->addToRhs(i, node->qGrad * node->head);
+        xQ[i] -= outflow[i];
+        matrixSolver->addToDiag(i, qGrad[i]);
+        matrixSolver->addToRhs(i, qGrad[i] * head[i]);
       }
 
       // ... add node's net inflow to r.h.s. row
@@ -556,7 +581,7 @@ void GGASolver::setNodeCoeffs() {
 
     else {
       matrixSolver->setDiag(i, 1.0);
-      matrixSolver->setRhs(i, node->head);
+      matrixSolver->setRhs(i, head[i]);
     }
   }
 }
@@ -566,28 +591,28 @@ void GGASolver::setNodeCoeffs() {
 //  Compute matrix coefficients for pressure regulating valves.
 
 void GGASolver::setValveCoeffs() {
-  for (Link *link : network->links) {
-    // ... skip links that are not active pressure regulating valves
+  for (int j : hydState.valveLinks) {
+    // ... skip valves that are not active
 
-    if (link->hGrad > 0.0)
+    if (hydState.hGrad[j] > 0.0)
       continue;
 
     // ... determine end node indexes of link
 
-    int n1 = link->fromNode->index;
-    int n2 = link->toNode->index;
+    int n1 = hydState.fromNode[j];
+    int n2 = hydState.toNode[j];
 
     // ... add net inflow of downstream node of a PRV to the
     //     r.h.s. row of its upstream node
 
-    if (link->isPRV()) {
+    if (hydState.linkKind[j] == HydState::PRV) {
       matrixSolver->addToRhs(n1, (double)xQ[n2]);
     }
 
     // ... add net inflow of upstream node of a PSV to the
     //     r.h.s. row of its downstream node
 
-    if (link->isPSV()) {
+    if (hydState.linkKind[j] == HydState::PSV) {
       matrixSolver->addToRhs(n2, (double)xQ[n1]);
     }
   }
@@ -598,6 +623,10 @@ void GGASolver::setValveCoeffs() {
 //  Check if any links change status at the current trial solution.
 
 bool GGASolver::linksChangedStatus() {
+  // ... the status functions work on the network's elements
+
+  hydState.scatter(network);
+
   bool result = false;
   for (Link *link : network->links) {
     // ... get head at each end of link
@@ -637,5 +666,8 @@ bool GGASolver::linksChangedStatus() {
   if (Control::applyPressureControls(network))
     result = true;
 
+  // ... closed links have their flows reset
+
+  hydState.gather(network);
   return result;
 }
@@ -14,8 +14,10 @@
 
 #include "Core/hydbalance.h"
 #include "Solvers/hydsolver.h"
+#include "Solvers/hydstate.h"
 #include "Utilities/utilities.h"
 
+#include <cstring>
 #include <string>
 #include <vector>
 class HydSolver;
@@ -76,7 +78,14 @@ public:
     xQ = j.at("xQ").get<std::vector<double>>();
   }
 
-  void copy_to(HydSolverData &data) const override {
+  // The snapshot holds HydSolverData followed by dH, dQ and xQ
+  size_t dataSize() const override {
+    return Utilities::alignSize(sizeof(HydSolverData)) +
+           (dH.size() + dQ.size() + xQ.size()) * sizeof(double);
+  }
+
+  void copy_to(char *buf) const override {
+    HydSolverData data;
     data.hLossEvalCount = hLossEvalCount;
     data.stepSizing = stepSizing;
     data.trialsLimit = trialsLimit;
@@ -90,12 +99,20 @@ public:
     data.errorNorm = errorNorm;
     data.oldErrorNorm = oldErrorNorm;
     hydBalance.copy_to(data.hydBalance);
-    data.dH = dH;
-    data.dQ = dQ;
-    data.xQ = xQ;
+    std::memcpy(buf, &data, sizeof(data));
+
+    double *v = reinterpret_cast<double *>(
+        buf + Utilities::alignSize(sizeof(HydSolverData)));
+    std::memcpy(v, dH.data(), dH.size() * sizeof(double));
+    v += dH.size();
+    std::memcpy(v, dQ.data(), dQ.size() * sizeof(double));
+    v += dQ.size();
+    std::memcpy(v, xQ.data(), xQ.size() * sizeof(double));
   }
 
-  void copy_from(const HydSolverData &data) override {
+  void copy_from(const char *buf) override {
+    HydSolverData data;
+    std::memcpy(&data, buf, sizeof(data));
     hLossEvalCount = data.hLossEvalCount;
     stepSizing = data.stepSizing;
     trialsLimit = data.trialsLimit;
@@ -109,12 +126,17 @@ public:
     errorNorm = data.errorNorm;
     oldErrorNorm = data.oldErrorNorm;
     hydBalance.copy_from(data.hydBalance);
-    dH = data.dH;
-    dQ = data.dQ;
-    xQ = data.xQ;
+
+    const double *v = reinterpret_cast<const double *>(
+        buf + Utilities::alignSize(sizeof(HydSolverData)));
+    std::memcpy(dH.data(), v, dH.size() * sizeof(double));
+    v += dH.size();
+    std::memcpy(dQ.data(), v, dQ.size() * sizeof(double));
+    v += dQ.size();
+    std::memcpy(xQ.data(), v, xQ.size() * sizeof(double));
   }
 
-private:
+protected:
   int nodeCount;      // number of network nodes
   int linkCount;      // number of network links
   int hLossEvalCount; // number of head loss evaluations
@@ -132,6 +154,7 @@ private:
   double errorNorm;      // solution error norm
   double oldErrorNorm;   // previous error norm
   HydBalance hydBalance; // hydraulic balance results
+  HydState hydState;     // heads and flows being solved for
 
   std::vector<double> dH; // head change at each node (ft)
   std::vector<double> dQ; // flow change in each link (cfs)
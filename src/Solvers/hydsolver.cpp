@@ -10,6 +10,7 @@
 
 // Include header files for the different hydraulic solvers here.
 #include "ggasolver.h"
+#include "nullspacesolver.h"
 
 using namespace std;
 
@@ -22,5 +23,7 @@ HydSolver *HydSolver::factory(const string name, Network *nw,
                               MatrixSolver *ms) {
   if (name == "GGA")
     return new GGASolver(nw, ms);
+  if (name == "NULLSPACE")
+    return new NullSpaceSolver(nw, ms);
   return nullptr;
 }
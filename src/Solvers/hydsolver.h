@@ -34,9 +34,6 @@ public:
   double theta;
   double errorNorm;
   double oldErrorNorm;
-  std::vector<double> dH;
-  std::vector<double> dQ;
-  std::vector<double> xQ;
   HydBalanceData hydBalance;
 };
 
@@ -63,8 +60,12 @@ public:
   //! Deserialize from JSON for HydSolver
   virtual void from_json(const nlohmann::json &j) {}
 
-  virtual void copy_to(HydSolverData &data) const = 0;
-  virtual void copy_from(const HydSolverData &data) = 0;
+  // Size (bytes) of the solver's state in a flat snapshot
+  virtual size_t dataSize() const = 0;
+
+  // Copies the solver's state to/from a flat snapshot buffer
+  virtual void copy_to(char *buf) const = 0;
+  virtual void copy_from(const char *buf) = 0;
 
 protected:
   Network *network;
@@ -0,0 +1,132 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Distributed under the MIT License (see the LICENSE file for details).
+ *
+ */
+
+/////////////////////////////////////////////
+//  Implementation of the HydState class.  //
+/////////////////////////////////////////////
+
+#include "hydstate.h"
+#include "Core/network.h"
+#include "Elements/link.h"
+#include "Elements/node.h"
+#include "Elements/pipe.h"
+
+//-----------------------------------------------------------------------------
+
+//  Size the arrays and copy the network's topology
+
+void HydState::init(Network *nw) {
+  nodeCount = nw->count(Element::NODE);
+  linkCount = nw->count(Element::LINK);
+
+  fromNode.resize(linkCount);
+  toNode.resize(linkCount);
+  linkKind.resize(linkCount);
+  nodeType.resize(nodeCount);
+  valveLinks.clear();
+  tankNodes.clear();
+
+  for (int i = 0; i < linkCount; i++) {
+    Link *link = nw->link(i);
+    fromNode[i] = link->fromNode->index;
+    toNode[i] = link->toNode->index;
+    if (link->type() == Link::PIPE)
+      linkKind[i] = PIPE;
+    else if (link->isPRV())
+      linkKind[i] = PRV;
+    else if (link->isPSV())
+      linkKind[i] = PSV;
+    else if (link->isHpPump())
+      linkKind[i] = HP_PUMP;
+    else
+      linkKind[i] = PLAIN;
+    if (linkKind[i] == PRV || linkKind[i] == PSV)
+      valveLinks.push_back(i);
+  }
+
+  for (int i = 0; i < nodeCount; i++) {
+    nodeType[i] = (char)nw->node(i)->type();
+    if (nodeType[i] == Node::TANK)
+      tankNodes.push_back(i);
+  }
+
+  flow.resize(linkCount);
+  hLoss.resize(linkCount);
+  hGrad.resize(linkCount);
+  head.resize(nodeCount);
+  outflow.resize(nodeCount);
+  qGrad.resize(nodeCount);
+  fixedGrade.resize(nodeCount);
+  trialFlow.resize(linkCount);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Copy the network's hydraulic variables into the arrays
+
+void HydState::gather(Network *nw) {
+  batchLinks.clear();
+  objectLinks.clear();
+  batchResistance.clear();
+  batchLossFactor.clear();
+  batchDiameter.clear();
+  batchRoughness.clear();
+
+  for (int i = 0; i < linkCount; i++) {
+    Link *link = nw->link(i);
+    flow[i] = link->flow;
+    hLoss[i] = link->hLoss;
+    hGrad[i] = link->hGrad;
+
+    // ... open pipes without check valves go to the batched head loss
+    //     methods; closed pipes, check valves, pumps and valves use
+    //     their own findHeadLoss
+
+    Pipe *pipe = static_cast<Pipe *>(link);
+    if (linkKind[i] == PIPE && !pipe->hasCheckValve &&
+        pipe->status != Link::LINK_CLOSED &&
+        pipe->status != Link::TEMP_CLOSED) {
+      batchLinks.push_back(i);
+      batchResistance.push_back(pipe->resistance);
+      batchLossFactor.push_back(pipe->lossFactor);
+      batchDiameter.push_back(pipe->diameter);
+      batchRoughness.push_back(pipe->roughness);
+    } else
+      objectLinks.push_back(i);
+  }
+  batchFlow.resize(batchLinks.size());
+  batchHLoss.resize(batchLinks.size());
+  batchHGrad.resize(batchLinks.size());
+
+  for (int i = 0; i < nodeCount; i++) {
+    Node *node = nw->node(i);
+    head[i] = node->head;
+    outflow[i] = node->outflow;
+    qGrad[i] = node->qGrad;
+    fixedGrade[i] = node->fixedGrade;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Copy the arrays back into the network's elements
+
+void HydState::scatter(Network *nw) {
+  for (int i = 0; i < linkCount; i++) {
+    Link *link = nw->link(i);
+    link->flow = flow[i];
+    link->hLoss = hLoss[i];
+    link->hGrad = hGrad[i];
+  }
+  for (int i = 0; i < nodeCount; i++) {
+    Node *node = nw->node(i);
+    node->head = head[i];
+    node->outflow = outflow[i];
+    node->qGrad = qGrad[i];
+    node->fixedGrade = fixedGrade[i];
+  }
+}
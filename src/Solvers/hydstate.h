@@ -0,0 +1,91 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file hydstate.h
+//! \brief Describes the HydState class.
+
+#ifndef HYDSTATE_H_
+#define HYDSTATE_H_
+
+#include "Models/headlossmodel.h"
+
+#include <vector>
+
+class Network;
+
+//! \class HydState
+//! \brief Contiguous arrays of the hydraulic variables used by a solver.
+//!
+//! The Newton iterations of the GGA solver sweep over every node and link
+//! several times per trial. Instead of dereferencing the scattered Node and
+//! Link objects, they work on this structure-of-arrays copy. The copy is
+//! loaded from the network when a solution starts (gather) and written back
+//! to it when the solution ends (scatter). In between, the element objects
+//! are only used for what depends on their type (head loss, demand and
+//! status functions). The open pipes without check valves are also copied
+//! into a PipeBatch, so that their head losses are found by the batched
+//! methods of the head loss model.
+
+class HydState {
+public:
+  //! Kind of link, for the special cases of the solver loops
+  enum LinkKind { PLAIN, PIPE, PRV, PSV, HP_PUMP };
+
+  //! Sizes the arrays and copies the network's topology
+  void init(Network *nw);
+
+  //! Copies the network's hydraulic variables into the arrays
+  void gather(Network *nw);
+
+  //! Copies the arrays back into the network's elements
+  void scatter(Network *nw);
+
+  //! Parameters of the batched pipes
+  PipeBatch pipeBatch() const {
+    return {(int)batchLinks.size(), batchResistance.data(),
+            batchLossFactor.data(), batchDiameter.data(),
+            batchRoughness.data()};
+  }
+
+  int nodeCount = 0;
+  int linkCount = 0;
+
+  // Topology (fixed once the network is loaded)
+  std::vector<int> fromNode;      //!< start node index of each link
+  std::vector<int> toNode;        //!< end node index of each link
+  std::vector<char> linkKind;     //!< LinkKind of each link
+  std::vector<char> nodeType;     //!< Node::NodeType of each node
+  std::vector<int> valveLinks;    //!< indexes of the PRVs and PSVs
+  std::vector<int> tankNodes;     //!< indexes of the tanks
+
+  // Link variables
+  std::vector<double> flow;       //!< flow rate (cfs)
+  std::vector<double> hLoss;      //!< head loss (ft)
+  std::vector<double> hGrad;      //!< head loss gradient (ft/cfs)
+
+  // Node variables
+  std::vector<double> head;       //!< hydraulic head (ft)
+  std::vector<double> outflow;    //!< demand + emitter + leakage flow (cfs)
+  std::vector<double> qGrad;      //!< gradient of outflow w.r.t. head (cfs/ft)
+  std::vector<char> fixedGrade;   //!< true if head is fixed
+
+  // Head loss evaluation (the batch is rebuilt by gather, since link
+  // status changes move pipes in and out of it)
+  std::vector<double> trialFlow;       //!< link flows at the trial step (cfs)
+  std::vector<int> batchLinks;         //!< link index of each batched pipe
+  std::vector<int> objectLinks;        //!< links evaluated by their objects
+  std::vector<double> batchResistance; //!< resistance of each batched pipe
+  std::vector<double> batchLossFactor; //!< minor loss factor (ft/cfs^2)
+  std::vector<double> batchDiameter;   //!< diameter (ft)
+  std::vector<double> batchRoughness;  //!< roughness parameter
+  std::vector<double> batchFlow;       //!< trial flow of each batched pipe
+  std::vector<double> batchHLoss;      //!< head loss of each batched pipe
+  std::vector<double> batchHGrad;      //!< head loss gradient
+};
+
+#endif
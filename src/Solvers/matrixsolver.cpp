@@ -10,6 +10,7 @@
 
 // Include headers for the different matrix solvers here
 #include "sparspaksolver.h"
+#include "supernodalsolver.h"
 // #include "cholmodsolver.h"
 
 using namespace std;
@@ -22,5 +23,7 @@ MatrixSolver *MatrixSolver::factory(const string name, ostream &logger) {
   // if (name == "CHOLMOD") return new CholmodSolver();
   if (name == "SPARSPAK")
     return new SparspakSolver(logger);
+  if (name == "SUPERNODAL")
+    return new SupernodalSolver(logger);
   return nullptr;
 }
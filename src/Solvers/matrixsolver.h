@@ -19,13 +19,6 @@
 
 #include "Utilities/utilities.h"
 
-class MatrixSolverData {
-public:
-  std::vector<double> lnz;
-  std::vector<double> diag;
-  std::vector<double> rhs;
-};
-
 //! \class MatrixSolver
 //! \brief Abstract class for solving a set of linear equations.
 //!
@@ -42,6 +35,17 @@ public:
   virtual ~MatrixSolver();
   static MatrixSolver *factory(const std::string solver, std::ostream &logger);
 
+  //! Sets the method used by init() to order the rows ("MMD" or "ND")
+  //! and the coordinates of each row's node (for a geometric nested
+  //! dissection; -1e20 for a node without coordinates)
+  void setOrdering(const std::string &method,
+                   const std::vector<double> &xCoord = {},
+                   const std::vector<double> &yCoord = {}) {
+    ordering = method;
+    this->xCoord = xCoord;
+    this->yCoord = yCoord;
+  }
+
   virtual int init(int nRows, int nOffDiags, int offDiagRow[],
                    int offDiagCol[]) = 0;
   virtual void reset() = 0;
@@ -57,13 +61,26 @@ public:
   virtual void addToRhs(int row, double b) = 0;
   virtual int solve(int nRows, double x[]) = 0;
 
+  //! Discards a factorization kept for low-rank updates, so that the
+  //! next solve() factorizes the matrix from scratch
+  virtual void clearFactor() {}
+
   virtual void debug(std::ostream &out) {}
 
   virtual nlohmann::json to_json() const = 0;
   virtual void from_json(const nlohmann::json &j) = 0;
 
-  virtual void copy_to(MatrixSolverData &data) const = 0;
-  virtual void copy_from(const MatrixSolverData &data) = 0;
+  // Size (bytes) of the numeric factorization in a flat snapshot
+  virtual size_t dataSize() const = 0;
+
+  // Copies the numeric factorization to/from a flat snapshot buffer
+  virtual void copy_to(char *buf) const = 0;
+  virtual void copy_from(const char *buf) = 0;
+
+protected:
+  std::string ordering = "MMD";    //!< row ordering method
+  std::vector<double> xCoord;      //!< x-coordinate of each row's node
+  std::vector<double> yCoord;      //!< y-coordinate of each row's node
 };
 
 #endif
@@ -0,0 +1,401 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+#include "ndorder.h"
+#include "sparspak.h"
+
+#include <algorithm>
+#include <limits>
+#include <new>
+#include <utility>
+#include <vector>
+using namespace std;
+
+// Largest subgraph ordered by multiple minimum degree
+static const int LEAF_SIZE = 256;
+
+// Value of a node coordinate that was not supplied
+static const double NO_COORD = -1e20;
+
+// Label of the nodes that have been ordered
+static const int ORDERED = -1;
+
+//-----------------------------------------------------------------------------
+
+namespace {
+
+//  Recursive nested dissection of the graph of a matrix
+
+class Dissector {
+public:
+  Dissector(int n, const int *xadj, const int *adjncy, const double *x,
+            const double *y);
+  void run();
+
+  vector<int> order; // nodes (0-based) in elimination order
+
+private:
+  void pruneChains(vector<int> &nodes);
+  void dissect(vector<int> &nodes, int label);
+  bool splitByCoords(vector<int> &nodes, vector<int> &a, vector<int> &b,
+                     vector<int> &sep);
+  bool splitByLevels(vector<int> &nodes, int label, vector<int> &a,
+                     vector<int> &b, vector<int> &sep);
+  bool separate(vector<int> &nodes, vector<int> &a, vector<int> &b,
+                vector<int> &sep);
+  int bfs(int root, int label, vector<int> &visited);
+  void clearLevels(const vector<int> &nodes);
+  void orderLeaf(vector<int> &nodes, int label);
+
+  int n;
+  vector<int> xadj;   // 0-based adjacency lists
+  vector<int> adjncy;
+  const double *x;    // node coordinates (or nullptr)
+  const double *y;
+  vector<int> part;   // label of the subgraph each node belongs to
+  vector<int> level;  // BFS level (or side of a split) of each node
+  vector<int> local;  // index of a node within a leaf
+  int labels;         // number of labels used
+};
+
+//-----------------------------------------------------------------------------
+
+Dissector::Dissector(int n_, const int *xadj_, const int *adjncy_,
+                     const double *x_, const double *y_)
+    : n(n_), x(x_), y(y_), labels(1) {
+  xadj.resize(n + 1);
+  for (int i = 0; i <= n; i++)
+    xadj[i] = xadj_[i] - 1;
+  adjncy.resize(xadj[n]);
+  for (int k = 0; k < xadj[n]; k++)
+    adjncy[k] = adjncy_[k] - 1;
+  part.assign(n, 0);
+  level.assign(n, -1);
+  local.assign(n, -1);
+  order.reserve(n);
+}
+
+//-----------------------------------------------------------------------------
+
+void Dissector::run() {
+  vector<int> nodes;
+  pruneChains(nodes);
+  dissect(nodes, 0);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Order first the nodes that have at most two neighbors in the elimination
+//  graph, i.e. the trees hanging from the graph and the chains of pipes in
+//  series (a node with a single neighbor is eliminated without fill-in and
+//  one with two neighbors joins them by a single edge), and return the
+//  others, whose adjacency lists are replaced by those of the reduced graph.
+
+void Dissector::pruneChains(vector<int> &nodes) {
+  vector<vector<int>> adj(n);
+  for (int i = 0; i < n; i++)
+    adj[i].assign(adjncy.begin() + xadj[i], adjncy.begin() + xadj[i + 1]);
+
+  vector<int> queue;
+  vector<char> queued(n, 0);
+  for (int i = 0; i < n; i++) {
+    if (adj[i].size() <= 2) {
+      queue.push_back(i);
+      queued[i] = 1;
+    }
+  }
+  for (size_t k = 0; k < queue.size(); k++) {
+    int v = queue[k];
+    order.push_back(v);
+    part[v] = ORDERED;
+
+    // ... remove v from its neighbors' lists and join them
+    for (int u : adj[v])
+      adj[u].erase(find(adj[u].begin(), adj[u].end(), v));
+    if (adj[v].size() == 2) {
+      int a = adj[v][0], b = adj[v][1];
+      if (find(adj[a].begin(), adj[a].end(), b) == adj[a].end()) {
+        adj[a].push_back(b);
+        adj[b].push_back(a);
+      }
+    }
+    for (int u : adj[v]) {
+      if (!queued[u] && adj[u].size() <= 2) {
+        queue.push_back(u);
+        queued[u] = 1;
+      }
+    }
+    vector<int>().swap(adj[v]);
+  }
+
+  // ... adjacency lists of the reduced graph
+  for (int i = 0; i < n; i++) {
+    if (part[i] != ORDERED)
+      nodes.push_back(i);
+  }
+  adjncy.clear();
+  for (int i = 0; i < n; i++) {
+    xadj[i] = (int)adjncy.size();
+    adjncy.insert(adjncy.end(), adj[i].begin(), adj[i].end());
+  }
+  xadj[n] = (int)adjncy.size();
+}
+
+//-----------------------------------------------------------------------------
+
+//  Order the nodes (all labeled label): both halves first, the separator
+//  last.
+
+void Dissector::dissect(vector<int> &nodes, int label) {
+  if ((int)nodes.size() <= LEAF_SIZE) {
+    orderLeaf(nodes, label);
+    return;
+  }
+
+  vector<int> a, b, sep;
+  bool split = (x && y) ? splitByCoords(nodes, a, b, sep) : false;
+  if (!split) {
+    a.clear();
+    b.clear();
+    sep.clear();
+    split = splitByLevels(nodes, label, a, b, sep);
+  }
+  if (!split) {
+    orderLeaf(nodes, label);
+    return;
+  }
+
+  // ... the separator is ordered last, so its nodes leave the subgraphs
+  for (int v : sep)
+    part[v] = ORDERED;
+  int labelA = labels++;
+  int labelB = labels++;
+  for (int v : a)
+    part[v] = labelA;
+  for (int v : b)
+    part[v] = labelB;
+  vector<int>().swap(nodes);
+
+  dissect(a, labelA);
+  dissect(b, labelB);
+  order.insert(order.end(), sep.begin(), sep.end());
+}
+
+//-----------------------------------------------------------------------------
+
+//  Split the nodes at the median of their wider coordinate extent (not if
+//  one of them has no coordinates).
+
+bool Dissector::splitByCoords(vector<int> &nodes, vector<int> &a,
+                              vector<int> &b, vector<int> &sep) {
+  double xmin = numeric_limits<double>::max(), xmax = -xmin;
+  double ymin = xmin, ymax = -xmin;
+  for (int v : nodes) {
+    if (x[v] <= NO_COORD || y[v] <= NO_COORD)
+      return false;
+    xmin = min(xmin, x[v]);
+    xmax = max(xmax, x[v]);
+    ymin = min(ymin, y[v]);
+    ymax = max(ymax, y[v]);
+  }
+  const double *c = (xmax - xmin >= ymax - ymin) ? x : y;
+  size_t half = nodes.size() / 2;
+  nth_element(nodes.begin(), nodes.begin() + half, nodes.end(),
+              [c](int u, int v) {
+                return c[u] < c[v] || (c[u] == c[v] && u < v);
+              });
+  for (size_t k = 0; k < nodes.size(); k++)
+    level[nodes[k]] = k < half ? 1 : 2;
+  return separate(nodes, a, b, sep);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Split the nodes at the median of a breadth-first search from a
+//  pseudo-peripheral node; a disconnected subgraph is split between its
+//  first component and the rest.
+
+bool Dissector::splitByLevels(vector<int> &nodes, int label, vector<int> &a,
+                              vector<int> &b, vector<int> &sep) {
+  // ... find a pseudo-peripheral node (the last node reached by a BFS,
+  //     until the depth of the level structure stops growing)
+  vector<int> visited;
+  int root = nodes[0];
+  int depth = bfs(root, label, visited);
+  for (int sweep = 0; sweep < 4; sweep++) {
+    int far = visited.back();
+    clearLevels(visited);
+    int farDepth = bfs(far, label, visited);
+    clearLevels(visited);
+    if (farDepth <= depth) {
+      bfs(root, label, visited);
+      break;
+    }
+    root = far;
+    depth = bfs(root, label, visited);
+  }
+
+  // ... disconnected subgraph: no separator is needed
+  if (visited.size() < nodes.size()) {
+    for (int v : visited)
+      level[v] = -2;
+    for (int v : nodes)
+      (level[v] == -2 ? a : b).push_back(v);
+    clearLevels(nodes);
+    return true;
+  }
+
+  // ... the nodes reached first form one side, the others the other side
+  size_t half = visited.size() / 2;
+  for (size_t k = 0; k < visited.size(); k++)
+    level[visited[k]] = k < half ? 1 : 2;
+  return separate(visited, a, b, sep);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Divide the nodes between the sides saved in level (1 or 2) and a
+//  separator that covers every edge between the sides; the separator is
+//  built greedily from the nodes with the most edges to the other side.
+
+bool Dissector::separate(vector<int> &nodes, vector<int> &a, vector<int> &b,
+                         vector<int> &sep) {
+  // ... number of edges from each boundary node to the other side
+  vector<pair<int, int>> boundary;
+  for (int v : nodes) {
+    int cut = 0;
+    for (int k = xadj[v]; k < xadj[v + 1]; k++) {
+      int u = adjncy[k];
+      if (level[u] > 0 && level[u] != level[v])
+        cut++;
+    }
+    if (cut > 0)
+      boundary.push_back({-cut, v});
+  }
+  sort(boundary.begin(), boundary.end());
+
+  // ... a node joins the separator (side 0) if one of its edges to the
+  //     other side is not yet covered
+  for (auto &bv : boundary) {
+    int v = bv.second;
+    for (int k = xadj[v]; k < xadj[v + 1]; k++) {
+      int u = adjncy[k];
+      if (level[u] > 0 && level[u] != level[v]) {
+        level[v] = 0;
+        break;
+      }
+    }
+  }
+
+  for (int v : nodes) {
+    if (level[v] == 1)
+      a.push_back(v);
+    else if (level[v] == 2)
+      b.push_back(v);
+    else
+      sep.push_back(v);
+    level[v] = -1;
+  }
+  return !a.empty() && !b.empty();
+}
+
+//-----------------------------------------------------------------------------
+
+//  Breadth-first search of the subgraph labeled label, saving each node's
+//  level; returns the number of levels.
+
+int Dissector::bfs(int root, int label, vector<int> &visited) {
+  visited.clear();
+  visited.push_back(root);
+  level[root] = 0;
+  int depth = 0;
+  for (size_t head = 0; head < visited.size(); head++) {
+    int v = visited[head];
+    for (int k = xadj[v]; k < xadj[v + 1]; k++) {
+      int u = adjncy[k];
+      if (part[u] == label && level[u] < 0) {
+        level[u] = level[v] + 1;
+        depth = max(depth, level[u]);
+        visited.push_back(u);
+      }
+    }
+  }
+  return depth + 1;
+}
+
+//-----------------------------------------------------------------------------
+
+void Dissector::clearLevels(const vector<int> &nodes) {
+  for (int v : nodes)
+    level[v] = -1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Order the nodes of a small subgraph by multiple minimum degree.
+
+void Dissector::orderLeaf(vector<int> &nodes, int label) {
+  int m = nodes.size();
+  if (m <= 2) {
+    for (int v : nodes) {
+      order.push_back(v);
+      part[v] = ORDERED;
+    }
+    return;
+  }
+
+  // ... 1-based adjacency lists of the subgraph
+  for (int i = 0; i < m; i++)
+    local[nodes[i]] = i;
+  vector<int> sxadj(m + 1);
+  vector<int> sadjncy;
+  sxadj[0] = 1;
+  for (int i = 0; i < m; i++) {
+    int v = nodes[i];
+    for (int k = xadj[v]; k < xadj[v + 1]; k++) {
+      int u = adjncy[k];
+      if (part[u] == label)
+        sadjncy.push_back(local[u] + 1);
+    }
+    sxadj[i + 1] = (int)sadjncy.size() + 1;
+  }
+  sadjncy.push_back(0);
+
+  vector<int> sperm(m), sinvp(m), dhead(m), qsize(m), llist(m), marker(m);
+  int delta = -1;
+  int nofsub = 0;
+  int maxint = numeric_limits<int>::max();
+  sp_genmmd(&m, sxadj.data(), sadjncy.data(), sinvp.data(), sperm.data(),
+            &delta, dhead.data(), qsize.data(), llist.data(), marker.data(),
+            &maxint, &nofsub);
+
+  for (int i = 0; i < m; i++) {
+    int v = nodes[sperm[i] - 1];
+    order.push_back(v);
+    part[v] = ORDERED;
+  }
+}
+
+} // namespace
+
+//=============================================================================
+
+int ndOrder(int n, const int *xadj, const int *adjncy, const double *xCoord,
+            const double *yCoord, int *perm, int *invp) {
+  try {
+    Dissector dissector(n, xadj, adjncy, xCoord, yCoord);
+    dissector.run();
+    for (int k = 0; k < n; k++) {
+      perm[k] = dissector.order[k] + 1;
+      invp[dissector.order[k]] = k + 1;
+    }
+  } catch (const bad_alloc &) {
+    return 0;
+  }
+  return 1;
+}
@@ -0,0 +1,32 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file ndorder.h
+//! \brief Nested dissection ordering of a sparse symmetric matrix.
+
+#ifndef NDORDER_H_
+#define NDORDER_H_
+
+//! Orders the rows of a matrix by nested dissection.
+//!
+//! The nodes with at most two neighbors (dead ends and pipes in series)
+//! are ordered first. The rest of the graph is split in two by a vertex
+//! separator, whose rows are ordered after those of both halves, and each
+//! half is split again until it is small enough to be ordered by multiple
+//! minimum degree. A half is bisected along the wider extent of its nodes'
+//! coordinates when xCoord and yCoord are given for all of them (a missing
+//! coordinate is -1e20), and otherwise at the middle of a breadth-first
+//! search from a pseudo-peripheral node.
+//!
+//! xadj and adjncy are the 1-based adjacency lists of the SPARSPAK
+//! routines; perm and invp receive the 1-based ordering and its inverse.
+//! Returns 0 if memory could not be allocated.
+int ndOrder(int n, const int *xadj, const int *adjncy, const double *xCoord,
+            const double *yCoord, int *perm, int *invp);
+
+#endif
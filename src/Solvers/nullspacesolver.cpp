@@ -0,0 +1,409 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Distributed under the MIT License (see the LICENSE file for details).
+ *
+ */
+
+//////////////////////////////////////////////////////////
+//  Implementation of the null-space (loop flow) solver  //
+//////////////////////////////////////////////////////////
+
+#include "nullspacesolver.h"
+#include "Core/error.h"
+#include "Core/network.h"
+#include "Elements/junction.h"
+#include "Elements/link.h"
+#include "matrixsolver.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+using namespace std;
+
+static const string s_IllConditioned =
+    "  Loop flow matrix ill-conditioned at link ";
+static const string s_Fallback = "  Null-space solver not used for networks with ";
+static const string s_UseGGA = "; using the GGA solver instead";
+
+static const double Huge = numeric_limits<double>::max();
+
+//-----------------------------------------------------------------------------
+
+//  Constructor
+
+NullSpaceSolver::NullSpaceSolver(Network *nw, MatrixSolver *ms)
+    : GGASolver(nw, ms) {
+  // ... identify the features that make the GGA method necessary
+
+  if (network->option(Options::DEMAND_MODEL) != "FIXED")
+    fallback = "pressure dependent demands";
+  else if (network->leakageModel)
+    fallback = "pipe leakage";
+  else if (!hydState.valveLinks.empty())
+    fallback = "pressure regulating/sustaining valves";
+  else {
+    for (Node *node : network->nodes) {
+      if (node->type() == Node::JUNCTION &&
+          static_cast<Junction *>(node)->hasEmitter()) {
+        fallback = "emitters";
+        break;
+      }
+    }
+  }
+  if (!fallback.empty())
+    network->msgLog << endl << s_Fallback << fallback << s_UseGGA;
+
+  treeHead.resize(nodeCount, 0);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Destructor
+
+NullSpaceSolver::~NullSpaceSolver() {}
+
+//-----------------------------------------------------------------------------
+
+//  Solve network for heads and flows
+
+int NullSpaceSolver::solve(double tstep_, int &trials) {
+  // ... time weighted tanks are not fixed grade nodes, so the
+  //     GGA method solves for their heads
+
+  double w = network->option(Options::TIME_WEIGHT);
+  if (!fallback.empty() || (w > 0.0 && tstep_ > 0.0))
+    return GGASolver::solve(tstep_, trials);
+
+  // ... initialize variables
+
+  double lamda = 1.0;
+  bool statusChanged = true;
+  bool converged = false;
+
+  errorNorm = Huge;
+  hLossEvalCount = 0;
+  tstep = tstep_;
+  theta = 0.0;
+  trials = 1;
+  setConvergenceLimits();
+  hydState.gather(network);
+
+  // ... perform Newton iterations on the loop flows
+
+  while (trials <= trialsLimit) {
+    oldErrorNorm = errorNorm;
+
+    // ... re-build the loops for a new set of open links and give
+    //     the tree links the flows that satisfy continuity
+
+    if (statusChanged) {
+      if (!findLoops()) {
+        hydState.scatter(network);
+        return GGASolver::solve(tstep_, trials);
+      }
+      balanceTreeFlows();
+      oldErrorNorm = findErrorNorm(0.0);
+      lamda = 1.0;
+    }
+    statusChanged = false;
+
+    // ... find changes in loop flows and the link flows and
+    //     tree heads that result
+
+    int errorCode = findLoopFlowChanges();
+    if (errorCode >= 0) {
+      hydState.scatter(network);
+      Link *link = network->link(loopLink[errorCode]);
+      network->msgLog << endl << s_IllConditioned << link->name;
+      return HydSolver::FAILED_ILL_CONDITIONED;
+    }
+
+    // ... find step size to take for head/flow changes
+
+    lamda = findStepSize(trials);
+    updateSolution(lamda);
+
+    // ... check for convergence and then for link status changes
+
+    if (reportTrials)
+      reportTrial(trials, lamda);
+    converged = hasConverged();
+    if (converged)
+      statusChanged = linksChangedStatus();
+    if (converged && !statusChanged)
+      break;
+    trials++;
+  }
+  hydState.scatter(network);
+  if (trials > trialsLimit)
+    return HydSolver::FAILED_NO_CONVERGENCE;
+  return HydSolver::SUCCESSFUL;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Split the links into a spanning tree of the open links and a co-tree,
+//  and find the tree links that each co-tree link's loop runs through.
+//  Returns false if some node cannot be reached from a fixed grade node
+//  or if the loop system is not sparser than the nodal one.
+
+bool NullSpaceSolver::findLoops() {
+  // ... the loops only change with the closed links and fixed grade nodes
+
+  vector<char> closed(linkCount);
+  for (int k = 0; k < linkCount; k++) {
+    int status = network->link(k)->status;
+    closed[k] = (status == Link::LINK_CLOSED || status == Link::TEMP_CLOSED);
+  }
+  if (closed == treeClosed && hydState.fixedGrade == treeRoots)
+    return true;
+  treeClosed = closed;
+  treeRoots = hydState.fixedGrade;
+  loopSolver.reset();
+
+  if (graph.createSpanningTree(network, treeRoots, treeClosed) > 0) {
+    treeClosed.clear();
+    return false;
+  }
+
+  // ... find each node's parent and depth in the tree
+
+  const int *fromNode = hydState.fromNode.data();
+  const int *toNode = hydState.toNode.data();
+  const vector<int> &treeLinks = graph.treeLinks();
+  vector<int> depth(nodeCount, 0);
+  parentNode.assign(nodeCount, -1);
+  for (int n : graph.treeNodes()) {
+    int k = treeLinks[n];
+    if (k < 0)
+      continue;
+    int p = (fromNode[k] == n) ? toNode[k] : fromNode[k];
+    parentNode[n] = p;
+    depth[n] = depth[p] + 1;
+  }
+
+  // ... trace each loop from the co-tree link's end nodes back to their
+  //     nearest common ancestor (or to their roots, whose fixed heads
+  //     close the loop); the loop's flow runs from the link's start node
+  //     to its end node, so it returns to the start node along the tree
+
+  loopLink = graph.coTreeLinks();
+  int loopCount = (int)loopLink.size();
+  vector<int> pathLink;
+  vector<char> pathDir;
+  vector<int> pathBeg(loopCount + 1, 0);
+  for (int c = 0; c < loopCount; c++) {
+    int k = loopLink[c];
+    int a = fromNode[k];
+    int b = toNode[k];
+    while (a != b && (depth[a] > 0 || depth[b] > 0)) {
+      if (depth[a] >= depth[b]) {
+        int t = treeLinks[a];
+        pathLink.push_back(t);
+        pathDir.push_back(toNode[t] == a ? 1 : -1);
+        a = parentNode[a];
+      } else {
+        int t = treeLinks[b];
+        pathLink.push_back(t);
+        pathDir.push_back(fromNode[t] == b ? 1 : -1);
+        b = parentNode[b];
+      }
+    }
+    pathBeg[c + 1] = (int)pathLink.size();
+  }
+
+  // ... list the loops that run through each tree link
+
+  linkLoopBeg.assign(linkCount + 1, 0);
+  for (int t : pathLink)
+    linkLoopBeg[t + 1]++;
+  for (int k = 0; k < linkCount; k++)
+    linkLoopBeg[k + 1] += linkLoopBeg[k];
+  linkLoops.resize(pathLink.size());
+  linkLoopDir.resize(pathLink.size());
+  vector<int> next(linkLoopBeg.begin(), linkLoopBeg.end() - 1);
+  for (int c = 0; c < loopCount; c++) {
+    for (int m = pathBeg[c]; m < pathBeg[c + 1]; m++) {
+      int t = pathLink[m];
+      linkLoops[next[t]] = c;
+      linkLoopDir[next[t]] = pathDir[m];
+      next[t]++;
+    }
+  }
+
+  // ... two loops that share a tree link have an off-diagonal coeff.
+  //     in the loop system; in a meshed network the loops share
+  //     long paths, which makes the loop system the denser of the two
+
+  double pairCount = 0.0;
+  for (int k = 0; k < linkCount; k++) {
+    double m = linkLoopBeg[k + 1] - linkLoopBeg[k];
+    pairCount += m * (m - 1.0) / 2.0;
+  }
+  if (loopCount + pairCount > nodeCount + linkCount) {
+    fallback = "more loop than nodal matrix coefficients";
+    network->msgLog << endl << s_Fallback << fallback << s_UseGGA;
+    treeClosed.clear();
+    return false;
+  }
+
+  vector<int> offDiagRow;
+  vector<int> offDiagCol;
+  unordered_map<int64_t, int> offDiagIndex;
+  pairBeg.assign(linkCount + 1, 0);
+  pairOffDiag.clear();
+  pairDir.clear();
+  for (int k = 0; k < linkCount; k++) {
+    for (int m1 = linkLoopBeg[k]; m1 < linkLoopBeg[k + 1]; m1++) {
+      for (int m2 = m1 + 1; m2 < linkLoopBeg[k + 1]; m2++) {
+        int c1 = linkLoops[m1];
+        int c2 = linkLoops[m2];
+        int64_t key = (int64_t)c1 * loopCount + c2;
+        auto it = offDiagIndex.find(key);
+        if (it == offDiagIndex.end()) {
+          it = offDiagIndex.emplace(key, (int)offDiagRow.size()).first;
+          offDiagRow.push_back(c1);
+          offDiagCol.push_back(c2);
+        }
+        pairOffDiag.push_back(it->second);
+        pairDir.push_back(linkLoopDir[m1] * linkLoopDir[m2]);
+      }
+    }
+    pairBeg[k + 1] = (int)pairOffDiag.size();
+  }
+
+  // ... create a matrix solver for the loop system
+
+  dX.assign(loopCount, 0.0);
+  if (loopCount == 0)
+    return true;
+  loopSolver.reset(MatrixSolver::factory(
+      network->option(Options::MATRIX_SOLVER), network->msgLog));
+  if (loopSolver) {
+    loopSolver->setOrdering(network->option(Options::MATRIX_ORDERING));
+    if (!loopSolver->init(loopCount, (int)offDiagRow.size(),
+                          offDiagRow.data(), offDiagCol.data()))
+      loopSolver.reset();
+  }
+  if (!loopSolver)
+    throw SystemError(SystemError::MATRIX_SOLVER_NOT_OPENED);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Give the tree links the flows that satisfy flow continuity at every
+//  junction for the current co-tree link flows.
+
+void NullSpaceSolver::balanceTreeFlows() {
+  const int *fromNode = hydState.fromNode.data();
+  const int *toNode = hydState.toNode.data();
+  const vector<int> &treeLinks = graph.treeLinks();
+  double *flow = hydState.flow.data();
+
+  // ... excess inflow at each node from its demand and co-tree links
+
+  vector<double> excess(nodeCount, 0.0);
+  for (int i = 0; i < nodeCount; i++) {
+    if (hydState.nodeType[i] == Node::JUNCTION)
+      excess[i] = -network->node(i)->fullDemand;
+  }
+  for (int k : loopLink) {
+    excess[fromNode[k]] -= flow[k];
+    excess[toNode[k]] += flow[k];
+  }
+
+  // ... working up from the leaves, each tree link carries the excess
+  //     of the subtree below it (the roots absorb what remains)
+
+  const vector<int> &order = graph.treeNodes();
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    int n = *it;
+    int k = treeLinks[n];
+    if (k < 0)
+      continue;
+    flow[k] = (fromNode[k] == n) ? excess[n] : -excess[n];
+    excess[parentNode[n]] += excess[n];
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the heads along the tree from the fixed grade heads and the tree
+//  links' head losses, linearized for flow changes dq (if supplied).
+
+void NullSpaceSolver::findTreeHeads(const double *dq) {
+  const int *fromNode = hydState.fromNode.data();
+  const double *hLoss = hydState.hLoss.data();
+  const double *hGrad = hydState.hGrad.data();
+  const vector<int> &treeLinks = graph.treeLinks();
+
+  for (int n : graph.treeNodes()) {
+    int k = treeLinks[n];
+    if (k < 0) {
+      treeHead[n] = hydState.head[n];
+      continue;
+    }
+    double h = hLoss[k];
+    if (dq)
+      h += hGrad[k] * dq[k];
+    int p = parentNode[n];
+    treeHead[n] = (fromNode[k] == p) ? treeHead[p] - h : treeHead[p] + h;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the changes in loop flows that remove the head loss imbalance
+//  around each loop, and the resulting link flow and nodal head changes.
+//  Returns the index of the loop that made the matrix singular, or -1.
+
+int NullSpaceSolver::findLoopFlowChanges() {
+  const int *fromNode = hydState.fromNode.data();
+  const int *toNode = hydState.toNode.data();
+  const double *hLoss = hydState.hLoss.data();
+  const double *hGrad = hydState.hGrad.data();
+  int loopCount = (int)loopLink.size();
+
+  // ... the head imbalance around each loop, from the heads found
+  //     along the tree, is the r.h.s. of the loop system Z'GZ dx = e
+
+  findTreeHeads(nullptr);
+  if (loopCount > 0) {
+    loopSolver->reset();
+    for (int c = 0; c < loopCount; c++) {
+      int k = loopLink[c];
+      loopSolver->addToDiag(c, hGrad[k]);
+      loopSolver->setRhs(c,
+                         treeHead[fromNode[k]] - treeHead[toNode[k]] - hLoss[k]);
+    }
+    for (int k = 0; k < linkCount; k++) {
+      for (int m = linkLoopBeg[k]; m < linkLoopBeg[k + 1]; m++)
+        loopSolver->addToDiag(linkLoops[m], hGrad[k]);
+      for (int m = pairBeg[k]; m < pairBeg[k + 1]; m++)
+        loopSolver->addToOffDiag(pairOffDiag[m], pairDir[m] * hGrad[k]);
+    }
+    int errorCode = loopSolver->solve(loopCount, dX.data());
+    if (errorCode >= 0)
+      return errorCode;
+  }
+
+  // ... each link's flow changes by the sum of its loops' flow changes
+
+  fill(dQ.begin(), dQ.end(), 0.0);
+  for (int c = 0; c < loopCount; c++)
+    dQ[loopLink[c]] = dX[c];
+  for (int k = 0; k < linkCount; k++) {
+    for (int m = linkLoopBeg[k]; m < linkLoopBeg[k + 1]; m++)
+      dQ[k] += linkLoopDir[m] * dX[linkLoops[m]];
+  }
+
+  // ... the new heads are those along the tree at the new flows
+
+  findTreeHeads(dQ.data());
+  for (int i = 0; i < nodeCount; i++)
+    dH[i] = treeHead[i] - hydState.head[i];
+  return -1;
+}
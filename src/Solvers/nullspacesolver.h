@@ -0,0 +1,76 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file nullspacesolver.h
+//! \brief Describes the NullSpaceSolver class.
+
+#ifndef NULLSPACESOLVER_H_
+#define NULLSPACESOLVER_H_
+
+#include "Solvers/ggasolver.h"
+#include "Utilities/graph.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+//! \class NullSpaceSolver
+//! \brief A hydraulic solver that iterates on loop flows instead of heads.
+//!
+//! The links are split into a spanning tree, rooted at the fixed grade
+//! nodes, and a co-tree. Once the tree flows satisfy flow continuity, every
+//! flow correction that keeps it satisfied is a sum of loop flows, one for
+//! each co-tree link. Each Newton trial therefore solves a system whose size
+//! is the number of loops (Z'GZ, with Z the loop incidence matrix and G the
+//! head loss gradients) rather than the number of junctions, and the heads
+//! follow from the tree's head losses. The convergence tests, step sizing
+//! and status checks are those of the GGA solver.
+//!
+//! Demands that depend on pressure (pressure driven demands, emitters and
+//! leakage), pressure regulating/sustaining valves and time weighted tanks
+//! change which flows satisfy continuity or which heads are fixed during a
+//! trial. Networks that use them, whose open links do not connect every
+//! node to a fixed grade node, or whose loops share so many links that the
+//! loop system has more coefficients than the nodal one (e.g. grids) are
+//! solved by the GGA method instead.
+
+class NullSpaceSolver : public GGASolver {
+public:
+  NullSpaceSolver(Network *nw, MatrixSolver *ms);
+  ~NullSpaceSolver();
+  int solve(double tstep, int &trials);
+
+private:
+  std::string fallback; // why the network needs the GGA method ("" if not)
+  Graph graph;          // spanning tree and co-tree of the open links
+
+  // Loop structure (rebuilt when the closed links or fixed grade nodes
+  // change)
+  std::vector<char> treeClosed;  // closed status of each link
+  std::vector<char> treeRoots;   // fixed grade status of each node
+  std::vector<int> parentNode;   // parent of each node in the tree
+  std::vector<int> loopLink;     // co-tree link of each loop
+  std::vector<int> linkLoopBeg;  // start of each tree link's loop list
+  std::vector<int> linkLoops;    // loops that run through each tree link
+  std::vector<char> linkLoopDir; // +1/-1 if a loop's flow runs with/against
+                                 // the link's direction
+  std::vector<int> pairBeg;      // start of each tree link's loop pairs
+  std::vector<int> pairOffDiag;  // off-diagonal coeff. of each pair
+  std::vector<char> pairDir;     // product of the pair's directions
+  std::unique_ptr<MatrixSolver> loopSolver; // solver for the loop system
+
+  std::vector<double> treeHead; // heads found along the tree (ft)
+  std::vector<double> dX;       // loop flow changes (cfs)
+
+  bool findLoops();
+  void balanceTreeFlows();
+  void findTreeHeads(const double *dq);
+  int findLoopFlowChanges();
+};
+
+#endif
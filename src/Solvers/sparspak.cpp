@@ -86,9 +86,9 @@ int sp_genmmd(int *neqns, int *xadj, int *adjncy, int *invp, int *perm,
   int i__1;
 
   /* Local variables */
-  static int mdeg, ehead, i, mdlmt, mdnode;
+  int mdeg, ehead, i, mdlmt, mdnode;
   // extern /* Subroutine */ int mmdelm_(), mmdupd_(), mmdint_(), mmdnum_();
-  static int nextmd, tag, num;
+  int nextmd, tag, num;
 
   /* *************************************************************** */
 
@@ -272,7 +272,7 @@ int mmdint_(int *neqns, int *xadj, int *adjncy, int *dhead, int *dforw,
   int i__1;
 
   /* Local variables */
-  static int ndeg, node, fnode;
+  int ndeg, node, fnode;
 
   /* *************************************************************** */
 
@@ -356,7 +356,7 @@ int mmdelm_(int *mdnode, int *xadj, int *adjncy, int *dhead, int *dforw,
   int i__1, i__2;
 
   /* Local variables */
-  static int node, link, rloc, rlmt, i, j, nabor, rnode, elmnt, xqnbr, istop,
+  int node, link, rloc, rlmt, i, j, nabor, rnode, elmnt, xqnbr, istop,
       jstop, istrt, jstrt, nxnode, pvnode, nqnbrs, npv;
 
   /* *************************************************************** */
@@ -599,7 +599,7 @@ void mmdupd_(int *ehead, int *neqns, int *xadj, int *adjncy, int *delta,
   int i__1, i__2;
 
   /* Local variables */
-  static int node, mtag, link, mdeg0, i, j, enode, fnode, nabor, elmnt, istop,
+  int node, mtag, link, mdeg0, i, j, enode, fnode, nabor, elmnt, istop,
       jstop, q2head, istrt, jstrt, qxhead, iq2, deg, deg0;
 
   /* *************************************************************** */
@@ -948,7 +948,7 @@ int mmdnum_(int *neqns, int *perm, int *invp, int *qsize) {
   int i__1;
 
   /* Local variables */
-  static int node, root, nextf, father, nqsize, num;
+  int node, root, nextf, father, nqsize, num;
 
   /* *************************************************************** */
 
@@ -1119,7 +1119,7 @@ void sp_smbfct(int neqns, int *xadj, int *adjncy, int *perm, int *invp,
     jstrt = xadj[node];
     jstop = xadj[node + 1] - 1;
     if (jstrt > jstop)
-      continue;
+      goto L1500;
 
     /* USE RCHLNK TO LINK THROUGH THE STRUCTURE OF A(*,K) BELOW DIAGONAL */
     rchlnk[k] = np1;
@@ -7,20 +7,27 @@
  */
 
 #include "sparspaksolver.h"
+#include "ndorder.h"
 #include "sparspak.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstring>
 #include <ctime>
+#include <iomanip>
 #include <iostream>
 #include <limits>
+#include <mutex>
+#include <unordered_map>
 using namespace std;
 
 // Local module-level functions
 //-----------------------------------------------------------------------------
-int compress(int n, int nnz, int *xrow, int *xcol, int *xadj, int *adjncy,
-             int *xaij);
-void buildAdjncy(int n, int nnz, int *xrow, int *xcol, int *xadj, int *adjncy,
-                 int *adjncy2, int *xaij, int *nz);
+int compress(int n, int nnz, const int *xrow, const int *xcol, int *xadj,
+             int *adjncy, int *xaij);
+void buildAdjncy(int n, int nnz, const int *xrow, const int *xcol, int *xadj,
+                 int *adjncy, int *adjncy2, int *xaij, int *nz);
 void sortAdjncy(int n, int nnz, int *xadj, int *adjncy, int *xadj2,
                 int *adjncy2, int *nz);
 void transpose(int n, int *xadj1, int *adjncy1, int *xadj2, int *adjncy2,
@@ -28,125 +35,64 @@ void transpose(int n, int *xadj1, int *adjncy1, int *xadj2, int *adjncy2,
 int reorder(int n, int *xadj, int *adjncy, int *perm, int *invp, int &nnzl);
 int factorize(int n, int &nnzl, int *xadj, int *adjncy, int *perm, int *invp,
               int *xlnz, int *xnzsub, int *nzsub);
-void aij2lnz(int nnz, int *xrow, int *xcol, int *invp, int *xlnz, int *xnzsub,
-             int *nzsub, int *xaij);
+void aij2lnz(int nnz, const int *xrow, const int *xcol, const int *invp,
+             int *xlnz, int *xnzsub, int *nzsub, int *xaij);
+
+// Low-rank updates are used when a factorization costs more than this
+// many forward and backward substitutions
+static const double MinUpdateGain = 4.0;
+
+// A coeff. whose relative change is below this is left out of the updates
+// and accounted for by iterative refinement
+static const double UpdateTol = 1.0e-4;
+
+// Refinement stops when the largest correction is below this fraction of
+// the largest solution value, or after this many steps
+static const double RefineTol = 1.0e-10;
+static const int MaxRefineSteps = 4;
+
+// An update is rejected when it reduces a squared pivot by this factor
+static const double PivotTol = 1.0e-8;
 
 //-----------------------------------------------------------------------------
 
 SparspakSolver::SparspakSolver(ostream &logger)
-    : nrows(0), nnz(0), nnzl(0), perm(0), invp(0), xlnz(0), xnzsub(0), nzsub(0),
-      xaij(0), link(0), first(0), lnz(0), diag(0), rhs(0), temp(0),
-      msgLog(logger) {}
+    : nrows(0), nnz(0), nnzl(0), invp(0), xaij(0), link(0), first(0), lnz(0),
+      diag(0), rhs(0), temp(0), msgLog(logger), fLnz(0), fDiag(0), lLnz(0),
+      lDiag(0), sol(0), res(0), wvec(0), factored(false) {}
 
 //-----------------------------------------------------------------------------
 
 SparspakSolver::~SparspakSolver() {
-  delete[] perm;
-  delete[] invp;
-  delete[] xlnz;
-  delete[] xnzsub;
-  delete[] nzsub;
-  delete[] xaij;
   delete[] link;
   delete[] first;
   delete[] lnz;
   delete[] diag;
   delete[] rhs;
   delete[] temp;
+  delete[] fLnz;
+  delete[] fDiag;
+  delete[] lLnz;
+  delete[] lDiag;
+  delete[] sol;
+  delete[] res;
+  delete[] wvec;
 }
 
 //-----------------------------------------------------------------------------
 
 int SparspakSolver::init(int nrows_, int nnz_, int *xrow, int *xcol) {
-  // ... save number of equations and number of off-diagonal coeffs.
-  nrows = nrows_;
-  nnz = nnz_;
-
-  // ... allocate space for pointers from Aij to lnz
-  xaij = new int[nnz];
-  if (!xaij)
-    return 0;
-  memset(xaij, 0, nnz * sizeof(int));
-
-  // ... allocate space for row re-ordering
-  perm = new int[nrows];
-  invp = new int[nrows];
-  if (!perm || !invp)
+  // ... find the re-ordering and symbolic factorization of A, which are
+  //     shared by all solvers of the same network
+  symbolic = SparspakSymbolic::find(nrows_, nnz_, xrow, xcol, ordering,
+                                    xCoord, yCoord);
+  if (!symbolic)
     return 0;
-
-  // ... compress, re-order, and factorize coeff. matrix A
-  int *xadj;
-  int *adjncy;
-  int flag = 0;
-  for (;;) {
-    // ... allocate space for adjacency lists
-    xadj = new int[nrows + 1];
-    adjncy = new int[2 * nnz];
-    if (!xadj || !adjncy)
-      break;
-
-    // ... store matrix A in compressed format
-    if (!compress(nrows, nnz, xrow, xcol, xadj, adjncy, xaij))
-      break;
-
-    // ... re-order the rows of A to minimize fill-in
-    // clock_t startTime = clock();
-    if (!reorder(nrows, xadj, adjncy, perm, invp, nnzl))
-      break;
-
-    /************ DEBUG  ******************
-        cout << "\n nnzl = " << nnzl;
-
-        for (int i = 0; i < nrows; i++)
-        {
-            cout << "\n i = " << i << "  perm[i] = " << perm[i] << "  invp[i] =
-    " << invp[i];
-        }
-
-    *****************************************/
-
-    // ... allocate space for compressed storage of factorized matrix
-    xlnz = new int[nrows + 1];
-    xnzsub = new int[nrows + 1];
-    nzsub = new int[nnzl];
-    if (!xlnz || !xnzsub || !nzsub)
-      break;
-
-    // ... symbolically factorize A to produce L
-    if (!factorize(nrows, nnzl, xadj, adjncy, perm, invp, xlnz, xnzsub, nzsub))
-      break;
-
-    /*************  DEBUG  ********************
-            // ... report factorization results
-
-            int nnz0 = xadj[nrows] / 2;
-            double procTime = (double)(clock() - startTime) /
-                              (double)CLOCKS_PER_SEC * 1000.0;
-
-            msgLog << endl;
-            msgLog << "  Hydraulic Solution Matrix:" << endl;
-            msgLog << "  Number of rows          " << nrows << endl;
-            msgLog << "  Off-diagonal non-zeros  " << nnz << endl;
-            msgLog << "  Duplicate non-zeros     " << nnz - nnz0 << endl;
-            msgLog << "  Amount of fill-in       " << nnzl - nnz0 << endl;
-            msgLog << "  Processing time (msec)  " << procTime << endl;
-    ********************************************/
-
-    // ... all steps were successful
-    flag = 1;
-    break;
-  }
-
-  // ... free memory used for adjacency lists
-  delete[] xadj;
-  delete[] adjncy;
-
-  // ... return if error condition
-  if (!flag)
-    return flag;
-
-  // ... map off-diag coeffs. of A to positions in xlnz
-  aij2lnz(nnz, xrow, xcol, invp, xlnz, xnzsub, nzsub, xaij);
+  nrows = symbolic->nrows;
+  nnz = symbolic->nnz;
+  nnzl = symbolic->nnzl;
+  invp = symbolic->invp.data();
+  xaij = symbolic->xaij.data();
 
   // ... allocate space for coeffs. of L and r.h.s vector
   lnz = new double[nnzl];
@@ -161,12 +107,56 @@ int SparspakSolver::init(int nrows_, int nnz_, int *xrow, int *xcol) {
   link = new int[nrows];
   if (!temp || !first || !link)
     return 0;
+
+  // ... allocate space for a factor kept for low-rank updates
+  if (symbolic->factorOps > MinUpdateGain * symbolic->solveOps) {
+    fLnz = new double[nnzl];
+    fDiag = new double[nrows];
+    lLnz = new double[nnzl];
+    lDiag = new double[nrows];
+    sol = new double[nrows];
+    res = new double[nrows];
+    wvec = new double[nrows]();
+    if (!fLnz || !fDiag || !lLnz || !lDiag || !sol || !res || !wvec)
+      return 0;
+  }
   return 1;
 }
 
 //-----------------------------------------------------------------------------
 
 int SparspakSolver::solve(int n, double x[]) {
+  // ... update the factor of the previous matrix, or factorize A in a
+  //     copy of its coeffs., when low-rank updates are used
+  if (lLnz) {
+    bool refine = false;
+    if (!updateFactor(refine)) {
+      int flag = refactor();
+      if (flag >= 0)
+        return flag;
+      refine = false;
+    }
+
+    // ... solve the system with the factor, refining the solution if the
+    //     factor is of a slightly different matrix
+    memcpy(sol, rhs, nrows * sizeof(double));
+    sp_solve(nrows, const_cast<int *>(symbolic->xlnz.data()), lLnz,
+             const_cast<int *>(symbolic->xnzsub.data()),
+             const_cast<int *>(symbolic->nzsub.data()), lDiag, sol);
+    if (refine && !refineSolution()) {
+      int flag = refactor();
+      if (flag >= 0)
+        return flag;
+      memcpy(sol, rhs, nrows * sizeof(double));
+      sp_solve(nrows, const_cast<int *>(symbolic->xlnz.data()), lLnz,
+               const_cast<int *>(symbolic->xnzsub.data()),
+               const_cast<int *>(symbolic->nzsub.data()), lDiag, sol);
+    }
+    for (int i = 0; i < nrows; i++)
+      x[i] = sol[invp[i] - 1];
+    return -1;
+  }
+
   // ... call sp_numfct to numerically evaluate the factorized matrix L
 
   /*********  DEBUG  ****************************
@@ -181,6 +171,11 @@ int SparspakSolver::solve(int n, double x[]) {
       ++diag;  ++rhs;  ++invp;
   *********************************************/
 
+  // ... the Sparspak routines only read the symbolic arrays
+  int *xlnz = const_cast<int *>(symbolic->xlnz.data());
+  int *xnzsub = const_cast<int *>(symbolic->xnzsub.data());
+  int *nzsub = const_cast<int *>(symbolic->nzsub.data());
+
   int flag;
   sp_numfct(nrows, xlnz, lnz, xnzsub, nzsub, diag, link, first, temp, flag);
 
@@ -211,6 +206,197 @@ int SparspakSolver::solve(int n, double x[]) {
 
 //-----------------------------------------------------------------------------
 
+void SparspakSolver::debug(ostream &out) { symbolic->writeStats(out); }
+
+//-----------------------------------------------------------------------------
+
+//  Factorize a copy of A, keeping the coeffs. it was computed from.
+
+int SparspakSolver::refactor() {
+  int *xlnz = const_cast<int *>(symbolic->xlnz.data());
+  int *xnzsub = const_cast<int *>(symbolic->xnzsub.data());
+  int *nzsub = const_cast<int *>(symbolic->nzsub.data());
+
+  memcpy(lLnz, lnz, nnzl * sizeof(double));
+  memcpy(lDiag, diag, nrows * sizeof(double));
+  int flag;
+  sp_numfct(nrows, xlnz, lLnz, xnzsub, nzsub, lDiag, link, first, temp, flag);
+  if (flag) {
+    factored = false;
+    return invp[flag - 1] - 1;
+  }
+  memcpy(fLnz, lnz, nnzl * sizeof(double));
+  memcpy(fDiag, diag, nrows * sizeof(double));
+  factored = true;
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Bring the factor up to date with A by low-rank updates, if that is
+//  cheaper than a new factorization; refine is set if some coeffs. of A
+//  were too close to the factorized ones to be worth an update.
+
+bool SparspakSolver::updateFactor(bool &refine) {
+  if (!factored)
+    return false;
+  const int *xlnz = symbolic->xlnz.data();
+  const int *xnzsub = symbolic->xnzsub.data();
+  const int *nzsub = symbolic->nzsub.data();
+  const double *pathOps = symbolic->pathOps.data();
+
+  // ... an off-diag. coeff. that changed by d is a rank-one change of
+  //     -d (e_j - e_i)(e_j - e_i)', which also changes both diagonals
+  //     by -d; res holds what is left of each diagonal's change
+  updates.clear();
+  refine = false;
+  double ops = 0.0;
+  for (int i = 0; i < nrows; i++)
+    res[i] = diag[i] - fDiag[i];
+  for (int j = 0; j < nrows; j++) {
+    int ksub = xnzsub[j] - 1;
+    for (int k = xlnz[j] - 1; k < xlnz[j + 1] - 1; k++, ksub++) {
+      double d = lnz[k] - fLnz[k];
+      if (d == 0.0)
+        continue;
+      if (fabs(d) <= UpdateTol * max(fabs(lnz[k]), fabs(fLnz[k]))) {
+        refine = true;
+        continue;
+      }
+      int i = nzsub[ksub] - 1;
+      updates.push_back({-d, j, i, k});
+      res[j] += d;
+      res[i] += d;
+      ops += pathOps[j];
+    }
+    if (ops >= symbolic->factorOps)
+      return false;
+  }
+  for (int i = 0; i < nrows; i++) {
+    double d = res[i];
+    if (d == 0.0)
+      continue;
+    if (fabs(d) <= UpdateTol * max(fabs(diag[i]), fabs(fDiag[i]))) {
+      refine = true;
+      continue;
+    }
+    updates.push_back({d, i, -1, -1});
+    ops += pathOps[i];
+  }
+
+  // ... a refinement step costs a product with A and a solve
+  if (refine)
+    ops += 2.0 * (symbolic->solveOps + nnzl + nrows);
+  if (ops >= symbolic->factorOps)
+    return false;
+
+  // ... apply the updates before the downdates, so that the intermediate
+  //     matrices stay positive definite
+  stable_partition(updates.begin(), updates.end(),
+                   [](const Update &u) { return u.sigma > 0.0; });
+  for (const Update &u : updates) {
+    if (!rankOneUpdate(u)) {
+      factored = false;
+      return false;
+    }
+    if (u.k >= 0) {
+      fLnz[u.k] = lnz[u.k];
+      fDiag[u.i] += u.sigma;
+    }
+    fDiag[u.j] += u.sigma;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Update the factor L of fLnz/fDiag to that of the matrix plus
+//  u.sigma * w w', with w = e_j - e_i, walking up the elimination tree from
+//  column j (the only columns whose coeffs. change).
+
+bool SparspakSolver::rankOneUpdate(const Update &u) {
+  const int *xlnz = symbolic->xlnz.data();
+  const int *xnzsub = symbolic->xnzsub.data();
+  const int *nzsub = symbolic->nzsub.data();
+  const int *parent = symbolic->parent.data();
+
+  double sign = u.sigma > 0.0 ? 1.0 : -1.0;
+  double *w = wvec;
+  w[u.j] = sqrt(fabs(u.sigma));
+  if (u.i >= 0)
+    w[u.i] = -w[u.j];
+
+  for (int j = u.j; j >= 0; j = parent[j]) {
+    double wj = w[j];
+    if (wj == 0.0)
+      continue;
+    w[j] = 0.0;
+
+    // ... new pivot, rejected if a downdate cancels most of it
+    double ljj = lDiag[j];
+    double r2 = ljj * ljj + sign * wj * wj;
+    if (r2 <= PivotTol * ljj * ljj) {
+      for (j = parent[j]; j >= 0; j = parent[j])
+        w[j] = 0.0;
+      return false;
+    }
+    double r = sqrt(r2);
+    double c = r / ljj;
+    double s = wj / ljj;
+    lDiag[j] = r;
+
+    // ... rotate column j of L with w
+    int ksub = xnzsub[j] - 1;
+    for (int k = xlnz[j] - 1; k < xlnz[j + 1] - 1; k++, ksub++) {
+      int i = nzsub[ksub] - 1;
+      double lij = (lLnz[k] + sign * s * w[i]) / c;
+      w[i] = c * w[i] - s * lij;
+      lLnz[k] = lij;
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Refine the solution in sol, found with the factor of a matrix close to
+//  A; returns false if it does not converge.
+
+bool SparspakSolver::refineSolution() {
+  int *xlnz = const_cast<int *>(symbolic->xlnz.data());
+  int *xnzsub = const_cast<int *>(symbolic->xnzsub.data());
+  int *nzsub = const_cast<int *>(symbolic->nzsub.data());
+
+  for (int step = 0; step < MaxRefineSteps; step++) {
+    // ... residual b - Ax (A's lower triangle is stored by columns in lnz)
+    for (int i = 0; i < nrows; i++)
+      res[i] = rhs[i] - diag[i] * sol[i];
+    for (int j = 0; j < nrows; j++) {
+      int ksub = xnzsub[j] - 1;
+      for (int k = xlnz[j] - 1; k < xlnz[j + 1] - 1; k++, ksub++) {
+        int i = nzsub[ksub] - 1;
+        res[i] -= lnz[k] * sol[j];
+        res[j] -= lnz[k] * sol[i];
+      }
+    }
+
+    // ... correct the solution
+    sp_solve(nrows, xlnz, lLnz, xnzsub, nzsub, lDiag, res);
+    double maxCorr = 0.0;
+    double maxSol = 0.0;
+    for (int i = 0; i < nrows; i++) {
+      sol[i] += res[i];
+      maxCorr = max(maxCorr, fabs(res[i]));
+      maxSol = max(maxSol, fabs(sol[i]));
+    }
+    if (maxCorr <= RefineTol * maxSol)
+      return true;
+  }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+
 void SparspakSolver::reset() {
   memset(diag, 0, (nrows) * sizeof(double));
   memset(lnz, 0, (nnzl) * sizeof(double));
@@ -275,12 +461,249 @@ void SparspakSolver::addToRhs(int i, double value) {
 
 //=============================================================================
 
+// Cache of the symbolic factorizations, keyed by a hash of the pattern
+static std::mutex symbolicMutex;
+static std::unordered_multimap<uint64_t, std::shared_ptr<const SparspakSymbolic>>
+    symbolicCache;
+
+//  FNV-1a hash of the matrix size and non-zero pattern, of the ordering
+//  method and of the node coordinates
+
+static uint64_t patternHash(int nrows, int nnz, const int *xrow,
+                            const int *xcol, const string &ordering,
+                            const vector<double> &xCoord,
+                            const vector<double> &yCoord) {
+  uint64_t h = 14695981039346656037ULL;
+  auto mix = [&h](uint64_t v) {
+    h ^= v;
+    h *= 1099511628211ULL;
+  };
+  mix(nrows);
+  mix(nnz);
+  for (int k = 0; k < nnz; k++) {
+    mix((uint32_t)xrow[k]);
+    mix((uint32_t)xcol[k]);
+  }
+  for (char c : ordering)
+    mix((unsigned char)c);
+  for (size_t i = 0; i < xCoord.size(); i++) {
+    uint64_t bits[2];
+    memcpy(&bits[0], &xCoord[i], sizeof(double));
+    memcpy(&bits[1], &yCoord[i], sizeof(double));
+    mix(bits[0]);
+    mix(bits[1]);
+  }
+  return h;
+}
+
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<const SparspakSymbolic>
+SparspakSymbolic::find(int nrows, int nnz, const int *xrow, const int *xcol,
+                       const string &ordering, const vector<double> &xCoord,
+                       const vector<double> &yCoord) {
+  // ... the coordinates only matter to a nested dissection
+  static const vector<double> none;
+  bool useCoords = ordering == "ND" && (int)xCoord.size() == nrows &&
+                   (int)yCoord.size() == nrows;
+  const vector<double> &x = useCoords ? xCoord : none;
+  const vector<double> &y = useCoords ? yCoord : none;
+  uint64_t key = patternHash(nrows, nnz, xrow, xcol, ordering, x, y);
+
+  // ... the lock is held while building, so that the threads opening the
+  //     same network wait for one factorization instead of each making one
+  std::lock_guard<std::mutex> lock(symbolicMutex);
+  auto range = symbolicCache.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->matches(nrows, nnz, xrow, xcol, ordering, x, y))
+      return it->second;
+  }
+
+  std::shared_ptr<SparspakSymbolic> symbolic(new SparspakSymbolic());
+  symbolic->ordering = ordering;
+  symbolic->xCoord = x;
+  symbolic->yCoord = y;
+  if (!symbolic->build(nrows, nnz, xrow, xcol))
+    return nullptr;
+  symbolicCache.emplace(key, symbolic);
+  return symbolic;
+}
+
+//-----------------------------------------------------------------------------
+
+void SparspakSymbolic::clearCache() {
+  std::lock_guard<std::mutex> lock(symbolicMutex);
+  for (auto it = symbolicCache.begin(); it != symbolicCache.end();) {
+    if (it->second.use_count() == 1)
+      it = symbolicCache.erase(it);
+    else
+      ++it;
+  }
+}
+
+//-----------------------------------------------------------------------------
+
+bool SparspakSymbolic::matches(int nrows_, int nnz_, const int *xrow_,
+                               const int *xcol_, const string &ordering_,
+                               const vector<double> &xCoord_,
+                               const vector<double> &yCoord_) const {
+  return nrows == nrows_ && nnz == nnz_ && ordering == ordering_ &&
+         std::equal(xrow.begin(), xrow.end(), xrow_) &&
+         std::equal(xcol.begin(), xcol.end(), xcol_) && xCoord == xCoord_ &&
+         yCoord == yCoord_;
+}
+
+//-----------------------------------------------------------------------------
+
+void SparspakSymbolic::writeStats(ostream &out) const {
+  out << endl;
+  out << "  Hydraulic Solution Matrix:" << endl;
+  out << "  Ordering method         " << ordering << endl;
+  out << "  Number of rows          " << nrows << endl;
+  out << "  Off-diagonal non-zeros  " << nnz << endl;
+  out << "  Duplicate non-zeros     " << nnz - nnz0 << endl;
+  out << "  Amount of fill-in       " << nnzl - nnz0 << endl;
+  out << "  Non-zeros in factor L   " << nnzl << endl;
+  out << fixed << setprecision(2);
+  out << "  Ordering time (msec)    " << orderTime << endl;
+  out << "  Symbolic time (msec)    " << symbolicTime << endl;
+  out.unsetf(ios::floatfield);
+}
+
+//-----------------------------------------------------------------------------
+
+//  Re-order and symbolically factorize the matrix with a given pattern
+
+bool SparspakSymbolic::build(int nrows_, int nnz_, const int *xrow_,
+                             const int *xcol_) {
+  // ... save number of equations, number of off-diagonal coeffs.
+  //     and the pattern of A
+  nrows = nrows_;
+  nnz = nnz_;
+  xrow.assign(xrow_, xrow_ + nnz);
+  xcol.assign(xcol_, xcol_ + nnz);
+
+  // ... allocate space for pointers from Aij to lnz
+  xaij.assign(nnz, 0);
+
+  // ... allocate space for row re-ordering
+  perm.resize(nrows);
+  invp.resize(nrows);
+
+  // ... compress, re-order, and factorize coeff. matrix A
+  int *xadj;
+  int *adjncy;
+  int flag = 0;
+  for (;;) {
+    // ... allocate space for adjacency lists
+    xadj = new int[nrows + 1];
+    adjncy = new int[2 * nnz];
+    if (!xadj || !adjncy)
+      break;
+
+    // ... store matrix A in compressed format
+    if (!compress(nrows, nnz, xrow_, xcol_, xadj, adjncy, xaij.data()))
+      break;
+
+    // ... re-order the rows of A to minimize fill-in
+    nnz0 = (xadj[nrows] - 1) / 2;
+    auto startTime = std::chrono::steady_clock::now();
+    if (ordering == "ND") {
+      bool useCoords = !xCoord.empty();
+      if (!ndOrder(nrows, xadj, adjncy, useCoords ? xCoord.data() : nullptr,
+                   useCoords ? yCoord.data() : nullptr, perm.data(),
+                   invp.data()))
+        break;
+    } else if (!reorder(nrows, xadj, adjncy, perm.data(), invp.data(), nnzl))
+      break;
+    auto orderedTime = std::chrono::steady_clock::now();
+    orderTime = std::chrono::duration<double, std::milli>(orderedTime -
+                                                          startTime)
+                    .count();
+
+    // ... allocate space for compressed storage of factorized matrix
+    //     (the size of nzsub is only known in advance for a minimum
+    //     degree ordering, so it is grown until the factorization fits)
+    xlnz.resize(nrows + 1);
+    xnzsub.resize(nrows + 1);
+    int maxsub = nnzl;
+    if (ordering == "ND")
+      maxsub = xadj[nrows] + nrows;
+    bool factorized = false;
+    for (;;) {
+      nzsub.resize(maxsub);
+      nnzl = maxsub;
+
+      // ... symbolically factorize A to produce L
+      if (factorize(nrows, nnzl, xadj, adjncy, perm.data(), invp.data(),
+                    xlnz.data(), xnzsub.data(), nzsub.data())) {
+        factorized = true;
+        break;
+      }
+      if (ordering != "ND" || (double)maxsub * 2.0 > (double)nrows * nrows)
+        break;
+      maxsub *= 2;
+    }
+    if (!factorized)
+      break;
+    symbolicTime = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - orderedTime)
+                       .count();
+
+    // ... all steps were successful
+    flag = 1;
+    break;
+  }
+
+  // ... free memory used for adjacency lists
+  delete[] xadj;
+  delete[] adjncy;
+
+  // ... return if error condition
+  if (!flag)
+    return false;
+
+  // ... map off-diag coeffs. of A to positions in xlnz
+  aij2lnz(nnz, xrow_, xcol_, invp.data(), xlnz.data(), xnzsub.data(),
+          nzsub.data(), xaij.data());
+  countOps();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Find the elimination tree of L and the number of multiply-adds made by
+//  a factorization, a solve and a rank-one update from each column.
+
+void SparspakSymbolic::countOps() {
+  parent.assign(nrows, -1);
+  pathOps.assign(nrows, 0.0);
+  factorOps = 0.0;
+  for (int j = 0; j < nrows; j++) {
+    double len = xlnz[j + 1] - xlnz[j];
+    if (len > 0)
+      parent[j] = nzsub[xnzsub[j] - 1] - 1;
+    factorOps += len * (len + 3.0) / 2.0 + 1.0;
+  }
+  solveOps = 2.0 * (nnzl + nrows);
+
+  // ... a parent's column comes after its children's
+  for (int j = nrows - 1; j >= 0; j--) {
+    double len = xlnz[j + 1] - xlnz[j];
+    pathOps[j] = 2.0 * len + 4.0;
+    if (parent[j] >= 0)
+      pathOps[j] += pathOps[parent[j]];
+  }
+}
+
+//=============================================================================
+
 //  Store the matrix non-zero structure in a set of compressed adjacency lists
 //  adjncy, where xadj has pointers to the starting index of each list in
 //  adjncy.
 
-int compress(int n, int nnz, int *xrow, int *xcol, int *xadj, int *adjncy,
-             int *xaij) {
+int compress(int n, int nnz, const int *xrow, const int *xcol, int *xadj,
+             int *adjncy, int *xaij) {
   int flag = 0;
   int *xadj2 = 0;
   int *adjncy2 = 0;
@@ -316,8 +739,8 @@ int compress(int n, int nnz, int *xrow, int *xcol, int *xadj, int *adjncy,
 
 //  Save the column index of each non-zero coefficient in a list for each row.
 
-void buildAdjncy(int n, int nnz, int *xrow, int *xcol, int *xadj, int *adjncy,
-                 int *adjncy2, int *xaij, int *nz) {
+void buildAdjncy(int n, int nnz, const int *xrow, const int *xcol, int *xadj,
+                 int *adjncy, int *adjncy2, int *xaij, int *nz) {
   int i, j, k, m, dup = 0;
 
   // ... use adjncy to temporarily store non-duplicate coeffs.
@@ -439,7 +862,7 @@ void transpose(int n, int *xadj1, int *adjncy1, int *xadj2, int *adjncy2,
 
 int reorder(int n, int *xadj, int *adjncy, int *perm, int *invp, int &nnzl) {
   // ... make a copy of the adjacency list
-  int nnz2 = xadj[n];
+  int nnz2 = xadj[n] - 1;
   int *adjncy2 = new int[nnz2];
   if (!adjncy2)
     return 0;
@@ -519,8 +942,8 @@ int factorize(int n, int &nnzl, int *xadj, int *adjncy, int *perm, int *invp,
 
 //  Map the original off-diagonal coeffs. of the matrix to its factorized form.
 
-void aij2lnz(int nnz, int *xrow, int *xcol, int *invp, int *xlnz, int *xnzsub,
-             int *nzsub, int *xaij) {
+void aij2lnz(int nnz, const int *xrow, const int *xcol, const int *invp,
+             int *xlnz, int *xnzsub, int *nzsub, int *xaij) {
   int i, j, ksub;
 
   // ... adjust arrays for non-zero offset
@@ -14,6 +14,75 @@
 
 #include "matrixsolver.h"
 
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+//! \class SparspakSymbolic
+//! \brief The ordering and symbolic factorization of a sparse matrix.
+//!
+//! Only depends on the matrix's non-zero pattern, i.e. on the network's
+//! topology. Once built it is never modified, so the SparspakSolvers of all
+//! Projects that load the same network share one instance, including across
+//! threads. Instances are cached by a hash of the pattern and of the
+//! ordering method (and node coordinates, for a nested dissection) and
+//! live until clearCache() is called.
+
+class SparspakSymbolic {
+public:
+  //! Returns the shared structure of a pattern, building it on first use
+  //! (nullptr if it could not be built)
+  static std::shared_ptr<const SparspakSymbolic>
+  find(int nrows, int nnz, const int *xrow, const int *xcol,
+       const std::string &ordering = "MMD",
+       const std::vector<double> &xCoord = {},
+       const std::vector<double> &yCoord = {});
+
+  //! Releases the cached structures not used by any solver
+  static void clearCache();
+
+  //! Writes the size, fill-in and processing time of the factorization
+  void writeStats(std::ostream &out) const;
+
+  int nrows = 0;            // number of rows in system Ax = b
+  int nnz = 0;              // number of non-zero off-diag. coeffs. in A
+  int nnzl = 0;             // number of non-zero off-diag. coeffs. in L
+  std::vector<int> perm;    // permutation of rows in A
+  std::vector<int> invp;    // inverse row permutation
+  std::vector<int> xlnz;    // index vector for non-zero entries in L
+  std::vector<int> xnzsub;  // index vector for entries of nzsub
+  std::vector<int> nzsub;   // column indexes for non-zero entries in each row of L
+  std::vector<int> xaij;    // maps off-diag. coeffs. of A to lnz
+
+  // Elimination tree and operation counts (used to decide between a
+  // low-rank update of a factorization and a new factorization)
+  std::vector<int> parent;     // parent of each column of L (-1 for a root)
+  std::vector<double> pathOps; // ops of an update from a column to its root
+  double factorOps = 0.0;      // ops of a numerical factorization
+  double solveOps = 0.0;       // ops of a forward and backward substitution
+
+  // Statistics
+  std::string ordering;     // ordering method ("MMD" or "ND")
+  int nnz0 = 0;             // number of distinct off-diag. coeffs. in A
+  double orderTime = 0.0;   // time to re-order the rows (msec)
+  double symbolicTime = 0.0; // time to symbolically factorize A (msec)
+
+private:
+  bool build(int nrows, int nnz, const int *xrow, const int *xcol);
+  void countOps();
+  bool matches(int nrows, int nnz, const int *xrow, const int *xcol,
+               const std::string &ordering, const std::vector<double> &xCoord,
+               const std::vector<double> &yCoord) const;
+
+  std::vector<int> xrow;    // row of each off-diag. coeff. (cache key)
+  std::vector<int> xcol;    // column of each off-diag. coeff. (cache key)
+  std::vector<double> xCoord; // node coordinates used by ND (cache key)
+  std::vector<double> yCoord;
+};
+
 //! \class SparspakSolver
 //! \brief Solves Ax = b using the SPARSPAK routines.
 //!
@@ -22,6 +91,15 @@
 //! and Liu, for re-ordering, factorizing, and solving via Cholesky
 //! decomposition a sparse, symmetric, positive definite set of linear
 //! equations Ax = b.
+//!
+//! On networks where a factorization is expensive, the factor of the last
+//! matrix is kept. When a new matrix differs from it in only a few
+//! coefficients (e.g. a pump or valve changed status) the factor receives
+//! one sparse rank-one update or downdate per changed link or node, and
+//! the coefficients that changed by less than a small relative amount
+//! are accounted for by iterative refinement of the solution. A new
+//! factorization is made instead when that would be cheaper, or when an
+//! update loses accuracy.
 
 class SparspakSolver : public MatrixSolver {
 public:
@@ -45,6 +123,9 @@ public:
   void addToOffDiag(int j, double a);
   void addToRhs(int i, double b);
   int solve(int n, double x[]);
+  void clearFactor() override { factored = false; }
+
+  void debug(std::ostream &out) override;
 
   //! Serialize to JSON for SparspakSolver
   nlohmann::json to_json() const override {
@@ -75,39 +156,32 @@ public:
     }
   }
 
-  void copy_to(MatrixSolverData &data) const override {
-    // resize if necessary
-    if (data.lnz.size() < nnzl) {
-      data.lnz.resize(nnzl);
-    }
-    if (data.diag.size() < nrows) {
-      data.diag.resize(nrows);
-    }
-    if (data.rhs.size() < nrows) {
-      data.rhs.resize(nrows);
-    }
-    // copy values
-    std::copy(lnz, lnz + nnzl, data.lnz.begin());
-    std::copy(diag, diag + nrows, data.diag.begin());
-    std::copy(rhs, rhs + nrows, data.rhs.begin());
+  // The snapshot holds lnz, diag and rhs (in this order)
+  size_t dataSize() const override {
+    return (nnzl + 2 * nrows) * sizeof(double);
   }
 
-  void copy_from(const MatrixSolverData &data) override {
-    std::copy(data.lnz.begin(), data.lnz.end(), lnz);
-    std::copy(data.diag.begin(), data.diag.end(), diag);
-    std::copy(data.rhs.begin(), data.rhs.end(), rhs);
+  void copy_to(char *buf) const override {
+    double *data = reinterpret_cast<double *>(buf);
+    std::memcpy(data, lnz, nnzl * sizeof(double));
+    std::memcpy(data + nnzl, diag, nrows * sizeof(double));
+    std::memcpy(data + nnzl + nrows, rhs, nrows * sizeof(double));
+  }
+
+  void copy_from(const char *buf) override {
+    const double *data = reinterpret_cast<const double *>(buf);
+    std::memcpy(lnz, data, nnzl * sizeof(double));
+    std::memcpy(diag, data + nnzl, nrows * sizeof(double));
+    std::memcpy(rhs, data + nnzl + nrows, nrows * sizeof(double));
   }
 
 private:
-  int nrows;    // number of rows in system Ax = b
-  int nnz;      // number of non-zero off-diag. coeffs. in A
-  int nnzl;     // number of non-zero off-diag. coeffs. in factorized matrix L
-  int *perm;    // permutation of rows in A
-  int *invp;    // inverse row permutation
-  int *xlnz;    // index vector for non-zero entries in L
-  int *xnzsub;  // index vector for entries of nzsub
-  int *nzsub;   // column indexes for non-zero entries in each row of L
-  int *xaij;    // maps off-diag. coeffs. of A to lnz
+  std::shared_ptr<const SparspakSymbolic> symbolic; // shared structure
+  int nrows;        // number of rows in system Ax = b
+  int nnz;          // number of non-zero off-diag. coeffs. in A
+  int nnzl;         // number of non-zero off-diag. coeffs. in factorized matrix L
+  const int *invp;  // inverse row permutation (from symbolic)
+  const int *xaij;  // maps off-diag. coeffs. of A to lnz (from symbolic)
   int *link;    // work array
   int *first;   // work array
   double *lnz;  // off-diag. coeffs. of factorized matrix L
@@ -115,6 +189,31 @@ private:
   double *rhs;  // right hand side vector
   double *temp; // work array
   std::ostream &msgLog;
+
+  // Low-rank updates (only allocated when a factorization costs several
+  // triangular solves). The factor is a cache that is not part of the
+  // snapshot: it stays valid for whatever matrix fLnz/fDiag hold.
+  double *fLnz;  // off-diag. coeffs. of the matrix factorized in lLnz
+  double *fDiag; // diagonal coeffs. of the matrix factorized in lDiag
+  double *lLnz;  // off-diag. coeffs. of its factor L
+  double *lDiag; // diagonal coeffs. of its factor L
+  double *sol;   // work array (solution in permuted order)
+  double *res;   // work array (residual, or change in each diagonal)
+  double *wvec;  // work array (update vector, zero between updates)
+  bool factored; // true if lLnz/lDiag hold the factor of fLnz/fDiag
+
+  struct Update {
+    double sigma; // A changes by sigma * (e_j - e_i)(e_j - e_i)'
+    int j;        // first row (in permuted order)
+    int i;        // second row (-1 for a change of a diagonal coeff.)
+    int k;        // position of the off-diag. coeff. in lnz (or -1)
+  };
+  std::vector<Update> updates;
+
+  int refactor();
+  bool updateFactor(bool &refine);
+  bool rankOneUpdate(const Update &u);
+  bool refineSolution();
 };
 
 #endif
@@ -0,0 +1,432 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+#include "supernodalsolver.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <mutex>
+using namespace std;
+
+//-----------------------------------------------------------------------------
+
+// Cache of the supernode partitions, keyed by the ordering they are built on
+// (each partition holds a reference to its ordering, which keeps the key
+// valid)
+static std::mutex supernodalMutex;
+static std::map<const SparspakSymbolic *,
+                std::shared_ptr<const SupernodalSymbolic>>
+    supernodalCache;
+
+//-----------------------------------------------------------------------------
+
+std::shared_ptr<const SupernodalSymbolic>
+SupernodalSymbolic::find(int nrows, int nnz, const int *xrow,
+                         const int *xcol, const std::string &ordering,
+                         const std::vector<double> &xCoord,
+                         const std::vector<double> &yCoord) {
+  std::shared_ptr<const SparspakSymbolic> sp = SparspakSymbolic::find(
+      nrows, nnz, xrow, xcol, ordering, xCoord, yCoord);
+  if (!sp)
+    return nullptr;
+
+  std::lock_guard<std::mutex> lock(supernodalMutex);
+  auto it = supernodalCache.find(sp.get());
+  if (it != supernodalCache.end())
+    return it->second;
+
+  std::shared_ptr<SupernodalSymbolic> symbolic(new SupernodalSymbolic());
+  symbolic->sparspak = sp;
+  if (!symbolic->build(*sp, xrow, xcol))
+    return nullptr;
+  supernodalCache.emplace(sp.get(), symbolic);
+  return symbolic;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Partition the columns of the symbolic factor L into supernodes and map
+//  the coeffs. of A to their panels
+
+bool SupernodalSymbolic::build(const SparspakSymbolic &sp, const int *xrow,
+                               const int *xcol) {
+  nrows = sp.nrows;
+  nnz = sp.nnz;
+  int n = nrows;
+
+  // ... number of off-diag. non-zeros in each column of L and the index
+  //     of the first one in nzsub (Sparspak's arrays are 1-based)
+  auto count = [&sp](int j) { return sp.xlnz[j + 1] - sp.xlnz[j]; };
+  auto colRows = [&sp](int j) { return &sp.nzsub[sp.xnzsub[j] - 1]; };
+
+  // ... column j+1 joins the supernode of column j if it is j's first
+  //     off-diag. row and has one less non-zero (the structure of L
+  //     then makes the rest of their rows identical)
+  xsuper.clear();
+  snode.resize(n);
+  for (int j = 0; j < n; j++) {
+    if (j == 0 || count(j - 1) != count(j) + 1 || colRows(j - 1)[0] != j + 1)
+      xsuper.push_back(j);
+    snode[j] = (int)xsuper.size() - 1;
+  }
+  nsuper = (int)xsuper.size();
+  xsuper.push_back(n);
+
+  // ... the rows of each panel are its own columns followed by the
+  //     off-diag. rows of its last column
+  xrows.resize(nsuper + 1);
+  xpanel.resize(nsuper + 1);
+  xrows[0] = 0;
+  xpanel[0] = 0;
+  maxld = 0;
+  for (int s = 0; s < nsuper; s++) {
+    int width = xsuper[s + 1] - xsuper[s];
+    int ld = width + count(xsuper[s + 1] - 1);
+    xrows[s + 1] = xrows[s] + ld;
+    long size = (long)xpanel[s] + (long)ld * width;
+    if (size > std::numeric_limits<int>::max())
+      return false;
+    xpanel[s + 1] = (int)size;
+    maxld = std::max(maxld, ld);
+  }
+  npanel = xpanel[nsuper];
+  rows.resize(xrows[nsuper]);
+  for (int s = 0; s < nsuper; s++) {
+    int last = xsuper[s + 1] - 1;
+    int *r = &rows[xrows[s]];
+    for (int j = xsuper[s]; j <= last; j++)
+      *r++ = j;
+    const int *sub = colRows(last);
+    for (int k = 0; k < count(last); k++)
+      *r++ = sub[k] - 1;
+  }
+
+  // ... position of the diagonal coeffs. (by permuted row)
+  xdiag.resize(n);
+  for (int s = 0; s < nsuper; s++) {
+    int ld = xrows[s + 1] - xrows[s];
+    for (int j = xsuper[s]; j < xsuper[s + 1]; j++) {
+      int c = j - xsuper[s];
+      xdiag[j] = xpanel[s] + c * ld + c;
+    }
+  }
+
+  // ... position of the off-diag. coeffs. (duplicates share a position)
+  xaij.resize(nnz);
+  for (int m = 0; m < nnz; m++) {
+    int i = sp.invp[xrow[m]] - 1;
+    int j = sp.invp[xcol[m]] - 1;
+    if (i < j)
+      std::swap(i, j);
+    int s = snode[j];
+    const int *r0 = &rows[xrows[s]];
+    const int *r1 = &rows[xrows[s + 1]];
+    const int *r = std::lower_bound(r0, r1, i);
+    if (r == r1 || *r != i)
+      return false;
+    int ld = (int)(r1 - r0);
+    xaij[m] = xpanel[s] + (j - xsuper[s]) * ld + (int)(r - r0);
+  }
+  return true;
+}
+
+//=============================================================================
+
+SupernodalSolver::SupernodalSolver(ostream &logger)
+    : nrows(0), npanel(0), invp(0), xdiag(0), xaij(0), lx(0), rhs(0), temp(0),
+      accum(0), map(0), link(0), first(0), msgLog(logger) {}
+
+//-----------------------------------------------------------------------------
+
+SupernodalSolver::~SupernodalSolver() {
+  delete[] lx;
+  delete[] rhs;
+  delete[] temp;
+  delete[] accum;
+  delete[] map;
+  delete[] link;
+  delete[] first;
+}
+
+//-----------------------------------------------------------------------------
+
+int SupernodalSolver::init(int nrows_, int nnz_, int *xrow, int *xcol) {
+  // ... find the ordering and supernode partition of A, which are shared
+  //     by all solvers of the same network
+  symbolic = SupernodalSymbolic::find(nrows_, nnz_, xrow, xcol, ordering,
+                                      xCoord, yCoord);
+  if (!symbolic)
+    return 0;
+  nrows = symbolic->nrows;
+  npanel = symbolic->npanel;
+  invp = symbolic->sparspak->invp.data();
+  xdiag = symbolic->xdiag.data();
+  xaij = symbolic->xaij.data();
+
+  // ... allocate space for the panels and r.h.s vector
+  lx = new double[npanel];
+  rhs = new double[nrows];
+  if (!lx || !rhs)
+    return 0;
+
+  // ... allocate space for work arrays used by the solve() method
+  temp = new double[symbolic->maxld];
+  accum = new double[nrows]();
+  map = new int[nrows];
+  link = new int[symbolic->nsuper];
+  first = new int[symbolic->nsuper];
+  if (!temp || !accum || !map || !link || !first)
+    return 0;
+  return 1;
+}
+
+//-----------------------------------------------------------------------------
+
+void SupernodalSolver::debug(std::ostream &out) {
+  symbolic->sparspak->writeStats(out);
+  out << "  Number of supernodes    " << symbolic->nsuper << std::endl;
+  out << "  Largest panel (rows)    " << symbolic->maxld << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+
+int SupernodalSolver::solve(int, double x[]) {
+  // ... numerically factorize A into L
+
+  int flag = factorize();
+
+  // if the matrix was ill-conditioned, return the problematic row
+  if (flag >= 0)
+    return symbolic->sparspak->perm[flag] - 1;
+
+  // ... forward substitution (solve Ly = b)
+
+  const int *xsuper = symbolic->xsuper.data();
+  const int *xrows = symbolic->xrows.data();
+  const int *xpanel = symbolic->xpanel.data();
+  const int *rows = symbolic->rows.data();
+  int nsuper = symbolic->nsuper;
+
+  for (int s = 0; s < nsuper; s++) {
+    int f = xsuper[s];
+    int width = xsuper[s + 1] - f;
+    int ld = xrows[s + 1] - xrows[s];
+    const int *r = rows + xrows[s];
+    const double *p = lx + xpanel[s];
+    for (int c = 0; c < width; c++, p += ld) {
+      double yc = rhs[f + c] / p[c];
+      rhs[f + c] = yc;
+      for (int k = c + 1; k < ld; k++)
+        rhs[r[k]] -= p[k] * yc;
+    }
+  }
+
+  // ... backward substitution (solve L'x = y)
+
+  for (int s = nsuper - 1; s >= 0; s--) {
+    int f = xsuper[s];
+    int width = xsuper[s + 1] - f;
+    int ld = xrows[s + 1] - xrows[s];
+    const int *r = rows + xrows[s];
+    for (int c = width - 1; c >= 0; c--) {
+      const double *p = lx + xpanel[s] + c * ld;
+      double yc = rhs[f + c];
+      for (int k = c + 1; k < ld; k++)
+        yc -= p[k] * rhs[r[k]];
+      rhs[f + c] = yc / p[c];
+    }
+  }
+
+  // ... transfer results from rhs to x
+  for (int i = 0; i < nrows; i++)
+    x[i] = rhs[invp[i] - 1];
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+//  Left-looking supernodal Cholesky factorization of the panels. Returns
+//  the (permuted) row with a non-positive pivot, or -1 if successful.
+
+int SupernodalSolver::factorize() {
+  const int *xsuper = symbolic->xsuper.data();
+  const int *snode = symbolic->snode.data();
+  const int *xrows = symbolic->xrows.data();
+  const int *xpanel = symbolic->xpanel.data();
+  const int *rows = symbolic->rows.data();
+  int nsuper = symbolic->nsuper;
+
+  // ... link[s] heads the list of supernodes that update supernode s
+  //     (-1 terminates a list)
+  for (int s = 0; s < nsuper; s++)
+    link[s] = -1;
+
+  for (int j = 0; j < nsuper; j++) {
+    int fj = xsuper[j];
+    int wj = xsuper[j + 1] - fj;
+    int ldj = xrows[j + 1] - xrows[j];
+    const int *rj = rows + xrows[j];
+    double *pj = lx + xpanel[j];
+
+    // ... position of each of the panel's rows (a single column instead
+    //     accumulates its updates by row, as the SPARSPAK routines do)
+    if (wj > 1) {
+      for (int k = 0; k < ldj; k++)
+        map[rj[k]] = k;
+    }
+
+    // ... apply the updates of each descendant supernode d, whose rows
+    //     from first[d] on start within supernode j
+    int d = link[j];
+    while (d >= 0) {
+      int nextd = link[d];
+      int ldd = xrows[d + 1] - xrows[d];
+      int wd = xsuper[d + 1] - xsuper[d];
+      const int *rd = rows + xrows[d];
+      const double *pd = lx + xpanel[d];
+      int p = first[d];
+      int m = ldd - p;
+      int q = 1;
+
+      if (wj == 1) {
+        for (int col = 0; col < wd; col++) {
+          const double *dcol = pd + col * ldd + p;
+          double lck = dcol[0];
+          for (int k = 0; k < m; k++)
+            accum[rd[p + k]] += dcol[k] * lck;
+        }
+      } else {
+        while (q < m && rd[p + q] < fj + wj)
+          q++;
+        // ... for each column c of j updated by d, subtract the dot
+        //     products of d's rows with row c (lower triangle only)
+        for (int c = 0; c < q; c++) {
+          double *jcol = pj + (rd[p + c] - fj) * ldj;
+          const int *rk = rd + p + c;
+          int len = m - c;
+          for (int k = 0; k < len; k++)
+            temp[k] = 0.0;
+          for (int col = 0; col < wd; col++) {
+            const double *dcol = pd + col * ldd + p + c;
+            double lck = dcol[0];
+            for (int k = 0; k < len; k++)
+              temp[k] += dcol[k] * lck;
+          }
+          for (int k = 0; k < len; k++)
+            jcol[map[rk[k]]] -= temp[k];
+        }
+      }
+
+      // ... move d to the list of the next supernode it updates
+      p += q;
+      if (p < ldd) {
+        first[d] = p;
+        int s = snode[rd[p]];
+        link[d] = link[s];
+        link[s] = d;
+      }
+      d = nextd;
+    }
+    if (wj == 1) {
+      for (int k = 0; k < ldj; k++) {
+        pj[k] -= accum[rj[k]];
+        accum[rj[k]] = 0.0;
+      }
+    }
+
+    // ... dense Cholesky factorization of the panel (the diagonal block
+    //     and the rows below it, one column at a time)
+    for (int c = 0; c < wj; c++) {
+      double *pc = pj + c * ldj;
+      double diagc = pc[c];
+      if (diagc <= 0.0)
+        return fj + c;
+      diagc = sqrt(diagc);
+      pc[c] = diagc;
+      for (int k = c + 1; k < ldj; k++)
+        pc[k] /= diagc;
+      for (int c2 = c + 1; c2 < wj; c2++) {
+        double *pc2 = pj + c2 * ldj;
+        double l = pc[c2];
+        for (int k = c2; k < ldj; k++)
+          pc2[k] -= pc[k] * l;
+      }
+    }
+
+    // ... add j to the list of the first supernode it updates
+    if (wj < ldj) {
+      first[j] = wj;
+      int s = snode[rj[wj]];
+      link[j] = link[s];
+      link[s] = j;
+    }
+  }
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+
+void SupernodalSolver::reset() {
+  memset(lx, 0, (npanel) * sizeof(double));
+  memset(rhs, 0, (nrows) * sizeof(double));
+}
+
+//-----------------------------------------------------------------------------
+
+double SupernodalSolver::getDiag(int i) {
+  int k = invp[i] - 1;
+  return lx[xdiag[k]];
+}
+
+//-----------------------------------------------------------------------------
+
+double SupernodalSolver::getOffDiag(int i) { return lx[xaij[i]]; }
+
+//-----------------------------------------------------------------------------
+
+double SupernodalSolver::getRhs(int i) {
+  int k = invp[i] - 1;
+  return rhs[k];
+}
+
+//-----------------------------------------------------------------------------
+
+void SupernodalSolver::setDiag(int i, double value) {
+  int k = invp[i] - 1;
+  lx[xdiag[k]] = value;
+}
+
+//-----------------------------------------------------------------------------
+
+void SupernodalSolver::setRhs(int i, double value) {
+  int k = invp[i] - 1;
+  rhs[k] = value;
+}
+
+//-----------------------------------------------------------------------------
+
+void SupernodalSolver::addToDiag(int i, double value) {
+  int k = invp[i] - 1;
+  lx[xdiag[k]] += value;
+}
+
+//-----------------------------------------------------------------------------
+
+void SupernodalSolver::addToOffDiag(int j, double value) {
+  lx[xaij[j]] += value;
+}
+
+//-----------------------------------------------------------------------------
+
+void SupernodalSolver::addToRhs(int i, double value) {
+  int k = invp[i] - 1;
+  rhs[k] += value;
+}
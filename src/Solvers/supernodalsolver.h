@@ -0,0 +1,154 @@
+/* EPANET 3
+ *
+ * Copyright (c) 2016 Open Water Analytics
+ * Licensed under the terms of the MIT License (see the LICENSE file for
+ * details).
+ *
+ */
+
+//! \file supernodalsolver.h
+//! \brief Description of the SupernodalSolver class.
+
+#ifndef SUPERNODALSOLVER_H_
+#define SUPERNODALSOLVER_H_
+
+#include "matrixsolver.h"
+#include "sparspaksolver.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+//! \class SupernodalSymbolic
+//! \brief The supernode partition of a matrix's Cholesky factor.
+//!
+//! A supernode is a set of contiguous columns of L with the same non-zero
+//! structure below their diagonal block. Each one is stored as a dense
+//! column-major panel whose rows are its own columns followed by the rows
+//! of that common structure. The partition is derived from the ordering
+//! and symbolic factorization of a SparspakSymbolic and, like it, is
+//! immutable and shared by all solvers of the same pattern.
+
+class SupernodalSymbolic {
+public:
+  //! Returns the shared partition of a pattern, building it on first use
+  //! (nullptr if it could not be built)
+  static std::shared_ptr<const SupernodalSymbolic>
+  find(int nrows, int nnz, const int *xrow, const int *xcol,
+       const std::string &ordering = "MMD",
+       const std::vector<double> &xCoord = {},
+       const std::vector<double> &yCoord = {});
+
+  std::shared_ptr<const SparspakSymbolic> sparspak; // ordering used
+
+  int nrows = 0;              // number of rows in system Ax = b
+  int nnz = 0;                // number of non-zero off-diag. coeffs. in A
+  int nsuper = 0;             // number of supernodes
+  int npanel = 0;             // size of all the panels
+  int maxld = 0;              // largest number of rows in a panel
+  std::vector<int> xsuper;    // first column of each supernode (+ nrows)
+  std::vector<int> snode;     // supernode of each column
+  std::vector<int> xrows;     // start of each supernode's rows in rows
+  std::vector<int> rows;      // row indexes of each panel
+  std::vector<int> xpanel;    // start of each panel in the values
+  std::vector<int> xdiag;     // position of each diagonal coeff.
+  std::vector<int> xaij;      // position of each off-diag. coeff. of A
+
+private:
+  bool build(const SparspakSymbolic &sp, const int *xrow, const int *xcol);
+};
+
+//! \class SupernodalSolver
+//! \brief Solves Ax = b by a supernodal Cholesky factorization.
+//!
+//! This class is derived from the MatrixSolver class. It uses the same
+//! row ordering as the SparspakSolver but factorizes the matrix
+//! one supernode at a time (left-looking): the updates from the
+//! descendant supernodes and the factorization of a panel are dense loops
+//! over contiguous columns, instead of the column-by-column indirect
+//! addressing of the SPARSPAK routines.
+
+class SupernodalSolver : public MatrixSolver {
+public:
+  // Constructor/Destructor
+
+  SupernodalSolver(std::ostream &logger);
+  ~SupernodalSolver();
+
+  // Methods
+
+  int init(int nrows, int nnz, int *xrow, int *xcol);
+  void reset();
+
+  double getDiag(int i);
+  double getOffDiag(int i);
+  double getRhs(int i);
+
+  void setDiag(int i, double a);
+  void setRhs(int i, double b);
+  void addToDiag(int i, double a);
+  void addToOffDiag(int j, double a);
+  void addToRhs(int i, double b);
+  int solve(int n, double x[]);
+
+  void debug(std::ostream &out) override;
+
+  //! Serialize to JSON for SupernodalSolver
+  nlohmann::json to_json() const override {
+    return {{"lx", lx ? nlohmann::json(std::vector<double>(lx, lx + npanel))
+                      : nlohmann::json(nullptr)},
+            {"rhs", rhs ? nlohmann::json(std::vector<double>(rhs, rhs + nrows))
+                        : nlohmann::json(nullptr)}};
+  }
+
+  //! Deserialize from JSON for SupernodalSolver
+  void from_json(const nlohmann::json &j) override {
+    if (lx) {
+      std::vector<double> lx_vec = j.at("lx").get<std::vector<double>>();
+      std::copy(lx_vec.begin(), lx_vec.end(), lx);
+    }
+
+    if (rhs) {
+      std::vector<double> rhs_vec = j.at("rhs").get<std::vector<double>>();
+      std::copy(rhs_vec.begin(), rhs_vec.end(), rhs);
+    }
+  }
+
+  // The snapshot holds lx and rhs (in this order)
+  size_t dataSize() const override {
+    return (npanel + nrows) * sizeof(double);
+  }
+
+  void copy_to(char *buf) const override {
+    double *data = reinterpret_cast<double *>(buf);
+    std::memcpy(data, lx, npanel * sizeof(double));
+    std::memcpy(data + npanel, rhs, nrows * sizeof(double));
+  }
+
+  void copy_from(const char *buf) override {
+    const double *data = reinterpret_cast<const double *>(buf);
+    std::memcpy(lx, data, npanel * sizeof(double));
+    std::memcpy(rhs, data + npanel, nrows * sizeof(double));
+  }
+
+private:
+  int factorize();
+
+  std::shared_ptr<const SupernodalSymbolic> symbolic; // shared structure
+  int nrows;        // number of rows in system Ax = b
+  int npanel;       // size of all the panels
+  const int *invp;  // inverse row permutation (from symbolic)
+  const int *xdiag; // position of each diagonal coeff. (from symbolic)
+  const int *xaij;  // position of each off-diag. coeff. (from symbolic)
+  double *lx;       // panels of A, overwritten by L
+  double *rhs;      // right hand side vector (permuted)
+  double *temp;     // work array (one panel column)
+  double *accum;    // work array (updates of a single column, by row)
+  int *map;         // work array (row -> position in target panel)
+  int *link;        // work array (supernodes updating a supernode)
+  int *first;       // work array (next row of each supernode to apply)
+  std::ostream &msgLog;
+};
+
+#endif
@@ -64,3 +64,63 @@ void Graph::createAdjLists(Network *nw) {
     throw;
   }
 }
+
+//-----------------------------------------------------------------------------
+
+//  Builds a spanning forest of a network's links by a breadth-first search
+//  started from all of the root nodes at once. Each node's path back to its
+//  root is therefore as short as possible, which keeps the loops formed by
+//  the co-tree links short as well.
+
+int Graph::createSpanningTree(Network *nw, const vector<char> &isRoot,
+                              const vector<char> &excluded) {
+  int nodeCount = nw->count(Element::NODE);
+  int linkCount = nw->count(Element::LINK);
+  if ((int)adjListBeg.size() != nodeCount + 1)
+    createAdjLists(nw);
+
+  treeOrder.clear();
+  treeOrder.reserve(nodeCount);
+  parentLink.assign(nodeCount, -1);
+  coTree.clear();
+
+  // ... start the search from the roots
+
+  vector<char> reached(nodeCount, 0);
+  for (int i = 0; i < nodeCount; i++) {
+    if (isRoot[i]) {
+      reached[i] = 1;
+      treeOrder.push_back(i);
+    }
+  }
+
+  // ... each link that reaches a new node becomes a tree link
+
+  vector<char> inTree(linkCount, 0);
+  for (size_t m = 0; m < treeOrder.size(); m++) {
+    int i = treeOrder[m];
+    for (int p = adjListBeg[i]; p < adjListBeg[i + 1]; p++) {
+      int k = adjLists[p];
+      if (excluded[k])
+        continue;
+      Link *link = nw->link(k);
+      int j = link->fromNode->index;
+      if (j == i)
+        j = link->toNode->index;
+      if (reached[j])
+        continue;
+      reached[j] = 1;
+      parentLink[j] = k;
+      inTree[k] = 1;
+      treeOrder.push_back(j);
+    }
+  }
+
+  // ... the remaining links make up the co-tree
+
+  for (int k = 0; k < linkCount; k++) {
+    if (!inTree[k])
+      coTree.push_back(k);
+  }
+  return nodeCount - (int)treeOrder.size();
+}
@@ -30,9 +30,28 @@ public:
 
   void createAdjLists(Network *nw);
 
+  //! Builds a breadth-first spanning forest of the links not flagged in
+  //! excluded[], rooted at the nodes flagged in isRoot[]; the other links
+  //! form the co-tree. Returns the number of nodes left unreached.
+  int createSpanningTree(Network *nw, const std::vector<char> &isRoot,
+                         const std::vector<char> &excluded);
+
+  //! Nodes in the order the tree reached them (roots first)
+  const std::vector<int> &treeNodes() const { return treeOrder; }
+
+  //! Link joining each node to its parent in the tree (-1 for roots and
+  //! unreached nodes)
+  const std::vector<int> &treeLinks() const { return parentLink; }
+
+  //! Links not in the tree (each one closes a loop)
+  const std::vector<int> &coTreeLinks() const { return coTree; }
+
 private:
   std::vector<int> adjLists;   // packed nodal adjacency lists
   std::vector<int> adjListBeg; // starting index of each node's list
+  std::vector<int> treeOrder;  // nodes in breadth-first order
+  std::vector<int> parentLink; // tree link to each node's parent
+  std::vector<int> coTree;     // links not in the tree
 };
 
 #endif // GRAPH_H_
@@ -78,6 +78,11 @@ public:
   static int getSeconds(const std::string &strTime,
                         const std::string &strUnits);
 
+  /// Rounds a size in bytes up to a multiple of the alignment of a double
+  static size_t alignSize(size_t n) {
+    return (n + alignof(double) - 1) / alignof(double) * alignof(double);
+  }
+
   /// Removes double quotes that surround a string
   static void removeQuotes(std::string &s);
 